@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Kvasir::Core::Fault {
+
+// fixed size list of code addresses leading to a fault, innermost first
+// addresses[0] is the faulting PC, the rest are return addresses (Thumb bit cleared), use
+// tools/symbolize_backtrace.py to turn them into function names and lines
+struct Backtrace {
+    static constexpr std::size_t depth = 8;
+
+    std::array<std::uint32_t, depth> addresses{};
+    std::uint8_t                     count{};
+
+    void push(std::uint32_t address) {
+        if(count < depth) { addresses[count++] = address; }
+    }
+};
+
+namespace Detail {
+    // return address (with Thumb bit) of a BL or BLX Rm, the only call instructions of ARMv6-M
+    static inline bool isReturnAddress(std::uint32_t word,
+                                       std::uint32_t codeBegin,
+                                       std::uint32_t codeEnd) {
+        if((word & 1U) == 0) { return false; }
+        std::uint32_t const address = word & ~1U;
+        if(address < codeBegin + 4 || address > codeEnd) { return false; }
+
+        auto const* const code = reinterpret_cast<std::uint16_t const*>(address);
+        std::uint16_t const first  = code[-2];
+        std::uint16_t const second = code[-1];
+        bool const          bl     = (first & 0xF800U) == 0xF000U && (second & 0xD000U) == 0xD000U;
+        bool const          blx    = (second & 0xFF87U) == 0x4780U;
+        return bl || blx;
+    }
+}   // namespace Detail
+
+// heuristic backtrace for ARMv6-M, there are no frame pointers and no unwind tables at runtime
+// so the stack above the exception frame is scanned for words that look like return addresses,
+// odd, inside [codeBegin, codeEnd) and preceded by a BL or BLX
+//
+// stale return addresses of returned calls can show up as well, the result is a hint and not a
+// precise call chain, the scan is bounded by maxWords so its time is bounded too
+// stack_ptr is the stacked exception frame as passed to Log(), stackTop the end of that stack
+static inline Backtrace captureBacktrace(std::uint32_t const* stack_ptr,
+                                         std::uint32_t const* stackTop,
+                                         std::uint32_t        codeBegin,
+                                         std::uint32_t        codeEnd,
+                                         std::size_t          maxWords = 256) {
+    Backtrace trace{};
+    trace.push(stack_ptr[6]);
+    if(Detail::isReturnAddress(stack_ptr[5], codeBegin, codeEnd)) {
+        trace.push(stack_ptr[5] & ~1U);
+    }
+
+    // the hardware frame is 8 words plus one of padding if xPSR bit 9 is set
+    std::uint32_t const* word = stack_ptr + 8 + ((stack_ptr[7] >> 9U) & 1U);
+    std::size_t const    available
+      = stackTop > word ? std::size_t(stackTop - word) : std::size_t(0);
+    std::uint32_t const* const end = word + (available < maxWords ? available : maxWords);
+
+    for(; word != end && trace.count < Backtrace::depth; ++word) {
+        if(Detail::isReturnAddress(*word, codeBegin, codeEnd)
+           && (*word & ~1U) != trace.addresses[trace.count - 1])
+        {
+            trace.push(*word & ~1U);
+        }
+    }
+    return trace;
+}
+
+}   // namespace Kvasir::Core::Fault
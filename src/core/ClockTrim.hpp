@@ -0,0 +1,109 @@
+#pragma once
+
+#include "CriticalSection.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+namespace Kvasir::Systick {
+
+// Clock corrected against an external reference (a 1PPS input, an RTC crystal, ...) so the
+// timestamps are accurate with a cheap inaccurate core clock
+//
+// the reference ISR reports every edge with referenceEdge(), the ticks measured between two
+// edges against the known reference period give the trim, a Q0.32 fraction added to the raw
+// tick rate, which is smoothed by 2^-SmoothingShift per edge
+// edges off by more than 1/64 of the period (missed or spurious edges) are ignored
+//
+// now() re-anchors on every trim change so it stays continuous and monotonic, the correction
+// is a few multiplies, no division, only referenceEdge() divides once
+template<typename Clock,
+         unsigned SmoothingShift = 2>
+struct TrimmedClock {
+    using duration   = typename Clock::duration;
+    using rep        = typename Clock::rep;
+    using period     = typename duration::period;
+    using time_point = std::chrono::time_point<TrimmedClock, duration>;
+
+    static constexpr bool is_steady = true;
+
+private:
+    static_assert(SmoothingShift < 16, "smoothing to slow to ever settle");
+
+    // longest reference period, keeps (expected - measured) << 32 within 64 bits
+    static constexpr std::uint64_t maxPeriod = std::uint64_t(1) << 37U;
+
+    // all state is written by referenceEdge() and read with interrupts masked
+    static inline std::uint64_t rawAnchor{};
+    static inline std::uint64_t trimmedAnchor{};
+    static inline std::uint64_t lastEdge{};
+    static inline std::int32_t  trim{};
+    static inline bool          haveEdge{};
+
+    static std::uint64_t raw(typename Clock::time_point t) {
+        return std::uint64_t(t.time_since_epoch().count());
+    }
+
+    // delta * (1 + trim / 2^32) split into 32 bit halves so nothing needs 128 bit
+    static std::uint64_t corrected(std::uint64_t delta) {
+        auto const high = std::int64_t(delta >> 32U) * trim;
+        auto const low  = (std::int64_t(delta & 0xFFFF'FFFFU) * trim) >> 32U;
+        return delta + std::uint64_t(high + low);
+    }
+
+    static std::uint64_t trimmed(std::uint64_t ticks) {
+        return trimmedAnchor + corrected(ticks - rawAnchor);
+    }
+
+public:
+    static time_point now() {
+        // read under the mask as well, a referenceEdge() in between would move rawAnchor past it
+        Core::CriticalSection cs;
+        return time_point{duration{rep(trimmed(raw(Clock::now())))}};
+    }
+
+    // call from the reference ISR for every edge, edge is when it happened (ideally captured in
+    // hardware), referencePeriod the nominal time between edges, false if the edge was ignored
+    static bool referenceEdge(typename Clock::time_point edge,
+                              duration                   referencePeriod) {
+        std::uint64_t const now      = raw(edge);
+        auto const          expected = std::int64_t(referencePeriod.count());
+
+        Core::CriticalSection cs;
+        bool                  accepted = false;
+        if(haveEdge && expected > 0 && std::uint64_t(expected) < maxPeriod && now > lastEdge) {
+            auto const measured = std::int64_t(now - lastEdge);
+            auto const diff     = expected - measured;
+            if((diff < 0 ? -diff : diff) <= (expected >> 6U)) {
+                auto const target = std::int32_t((diff * (std::int64_t(1) << 32U)) / measured);
+                // anchored at the current time, not the edge, so no earlier now() is passed
+                std::uint64_t const current = raw(Clock::now());
+                trimmedAnchor               = trimmed(current);
+                rawAnchor                   = current;
+                trim     = std::int32_t(trim + ((target - trim) >> std::int32_t(SmoothingShift)));
+                accepted = true;
+            }
+        }
+        lastEdge = now;
+        haveEdge = true;
+        return accepted;
+    }
+
+    static bool referenceEdge(duration referencePeriod) {
+        return referenceEdge(Clock::now(), referencePeriod);
+    }
+
+    template<typename Rep,
+             typename Period>
+    static bool referenceEdge(std::chrono::duration<Rep, Period> referencePeriod) {
+        return referenceEdge(Clock::now(), Clock::fromDuration(referencePeriod));
+    }
+
+    // current correction in parts per billion, positive when the core clock runs slow
+    static std::int32_t trimPpb() {
+        Core::CriticalSection cs;
+        return std::int32_t((std::int64_t(trim) * 1'000'000'000) >> 32U);
+    }
+};
+
+}   // namespace Kvasir::Systick
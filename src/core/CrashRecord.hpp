@@ -0,0 +1,142 @@
+#pragma once
+
+#include "Fault.hpp"
+#include "Sections.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace Kvasir::Core::Fault {
+
+// fixed layout binary record of one fault, little endian as stored by the core
+// tools/decode_crash.py has to be kept in sync with this layout
+struct CrashRecord {
+    static constexpr std::uint32_t validMagic = 0x4B43'5231;   // "KCR1"
+
+    std::uint32_t magic;
+    std::uint32_t sequence;
+    std::uint64_t timestamp;   // clock ticks, 0 without a clock
+    std::uint8_t  type;
+    std::uint8_t  description;
+    std::uint8_t  hasFaultAddress;
+    std::uint8_t  reserved;
+    std::uint32_t faultAddress;
+    std::uint32_t statusBits;
+    std::uint32_t frame[8];   // stacked r0, r1, r2, r3, r12, lr, pc, xPSR
+    std::uint32_t excReturn;
+    std::uint32_t reserved2;
+    std::uint32_t crc;   // CRC-32 of all bytes before
+};
+
+static_assert(std::is_trivially_copyable_v<CrashRecord> && sizeof(CrashRecord) == 72,
+              "CrashRecord layout is shared with the host decoder");
+
+namespace Detail {
+    // CRC-32 (IEEE, reflected) with a 16 entry table, small enough for the fault path
+    static constexpr std::uint32_t crc32(std::uint8_t const* data,
+                                         std::size_t         size) {
+        constexpr std::array<std::uint32_t, 16> table{
+          0x0000'0000, 0x1DB7'1064, 0x3B6E'20C8, 0x26D9'30AC, 0x76DC'4190, 0x6B6B'51F4,
+          0x4DB2'6158, 0x5005'713C, 0xEDB8'8320, 0xF00F'9344, 0xD6D6'A3E8, 0xCB61'B38C,
+          0x9B64'C2B0, 0x86D3'D2D4, 0xA00A'E278, 0xBDBD'F21C};
+        std::uint32_t crc = 0xFFFF'FFFF;
+        for(std::size_t i = 0; i < size; ++i) {
+            crc ^= data[i];
+            crc = (crc >> 4U) ^ table[crc & 0xFU];
+            crc = (crc >> 4U) ^ table[crc & 0xFU];
+        }
+        return ~crc;
+    }
+
+    static inline std::uint32_t crcOf(CrashRecord const& r) {
+        return crc32(reinterpret_cast<std::uint8_t const*>(&r), offsetof(CrashRecord, crc));
+    }
+
+    static inline bool isValid(CrashRecord const& r) {
+        return r.magic == CrashRecord::validMagic && r.crc == crcOf(r);
+    }
+}   // namespace Detail
+
+// ring of the last Depth crash records, meant to be placed in no-init RAM so it survives the
+// reset that follows a fault:
+//
+//   KVASIR_NO_INIT Kvasir::Core::Fault::CrashRing<4> crashRing;
+//
+// the content is random after power on, records are only trusted with magic and CRC intact
+// record() is the binary replacement for Log() in the HardFault handler, it does no formatting
+// and needs no log sink, drain() hands the records to the log once the system is up
+template<std::size_t Depth>
+struct CrashRing {
+    static_assert(Depth != 0, "a crash ring needs at least one record");
+
+    std::array<CrashRecord, Depth> records;
+
+    void record(std::uint32_t const* stack_ptr,
+                std::uint32_t        lr_value,
+                std::uint64_t        timestamp = 0) {
+        FaultInfo const info = GetFaultInfo();
+
+        // newest valid record decides the slot, a fresh ring starts at slot 0
+        std::uint32_t sequence = 0;
+        std::size_t   slot     = 0;
+        for(std::size_t i = 0; i < Depth; ++i) {
+            if(Detail::isValid(records[i]) && records[i].sequence >= sequence) {
+                sequence = records[i].sequence + 1U;
+                slot     = (i + 1) % Depth;
+            }
+        }
+
+        CrashRecord& r    = records[slot];
+        r.magic           = CrashRecord::validMagic;
+        r.sequence        = sequence;
+        r.timestamp       = timestamp;
+        r.type            = std::uint8_t(info.type);
+        r.description     = std::uint8_t(info.description);
+        r.hasFaultAddress = info.fault_address.has_value() ? 1 : 0;
+        r.reserved        = 0;
+        r.faultAddress    = info.fault_address.value_or(0);
+        r.statusBits      = info.status_bits;
+        for(std::size_t i = 0; i < 8; ++i) { r.frame[i] = stack_ptr[i]; }
+        r.excReturn = lr_value;
+        r.reserved2 = 0;
+        r.crc       = Detail::crcOf(r);
+    }
+
+    // stamps the record with Clock::now(), the clock has to be usable from the fault handler
+    template<typename Clock>
+    void record(std::uint32_t const* stack_ptr,
+                std::uint32_t        lr_value) {
+        record(stack_ptr,
+               lr_value,
+               std::uint64_t(Clock::now().time_since_epoch().count()));
+    }
+
+    // passes the valid records oldest first to sink(CrashRecord const&) and clears them
+    template<typename F>
+    std::size_t drain(F&& sink) {
+        std::size_t count = 0;
+        while(true) {
+            CrashRecord* oldest = nullptr;
+            for(auto& r : records) {
+                if(Detail::isValid(r) && (oldest == nullptr || r.sequence < oldest->sequence)) {
+                    oldest = &r;
+                }
+            }
+            if(oldest == nullptr) { return count; }
+            sink(static_cast<CrashRecord const&>(*oldest));
+            oldest->magic = 0;
+            ++count;
+        }
+    }
+
+    bool empty() const {
+        for(auto const& r : records) {
+            if(Detail::isValid(r)) { return false; }
+        }
+        return true;
+    }
+};
+
+}   // namespace Kvasir::Core::Fault
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Kvasir::Core {
+
+#if defined(__ARM_ARCH)
+// masks all configurable interrupts (PRIMASK) for the lifetime of the object and restores the
+// previous state on destruction, so nested sections are fine
+struct CriticalSection {
+    [[gnu::always_inline]] CriticalSection() {
+        asm volatile("mrs %0, primask\n\t"
+                     "cpsid i"
+                     : "=r"(primask)
+                     :
+                     : "memory");
+    }
+
+    [[gnu::always_inline]] ~CriticalSection() {
+        asm volatile("msr primask, %0" : : "r"(primask) : "memory");
+    }
+
+    CriticalSection(CriticalSection const&)            = delete;
+    CriticalSection& operator=(CriticalSection const&) = delete;
+
+private:
+    std::uint32_t primask;
+};
+#else
+// host builds (simulation, see HostSystick.hpp), PRIMASK is a flag and unmasking gives the
+// simulation the chance to deliver interrupts that became pending meanwhile
+namespace HostDetail {
+    inline bool primask{};
+    inline void (*onUnmask)(){};
+}   // namespace HostDetail
+
+struct CriticalSection {
+    CriticalSection() : primask{HostDetail::primask} { HostDetail::primask = true; }
+
+    ~CriticalSection() {
+        HostDetail::primask = primask;
+        if(!primask && HostDetail::onUnmask != nullptr) { HostDetail::onUnmask(); }
+    }
+
+    CriticalSection(CriticalSection const&)            = delete;
+    CriticalSection& operator=(CriticalSection const&) = delete;
+
+private:
+    bool primask;
+};
+#endif
+
+}   // namespace Kvasir::Core
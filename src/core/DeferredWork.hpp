@@ -0,0 +1,92 @@
+#pragma once
+
+#include "CriticalSection.hpp"
+#include "SystemControl.hpp"
+#include "core_peripherals/SCB.hpp"
+#include "kvasir/Common/Interrupt.hpp"
+#include "kvasir/Register/Register.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace Kvasir::Core {
+
+// ISR -> PendSV work queue, ISRs post a function and argument and return, the work runs later
+// in the PendSV handler at the lowest priority so it is preempted by every other interrupt
+//
+// ARMv6-M has no LDREX/STREX so post() masks interrupts (PRIMASK) for the few instructions that
+// claim a slot, work runs with interrupts enabled in FIFO order
+// the queue owns PendSV and can therefore not be combined with Kernel::Scheduler, with the
+// kernel drain() has to be called from a task instead
+template<std::size_t Capacity>
+struct WorkQueue {
+    using Work = void (*)(void*);
+
+private:
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "capacity has to be a power of two");
+    static_assert(Capacity <= 0x8000, "capacity to large for 16 bit indices");
+
+    using ScbRegs = Kvasir::Peripheral::SCB::Registers<>;
+
+    struct Item {
+        Work  work;
+        void* arg;
+    };
+
+    static inline std::array<Item, Capacity> items{};
+    // free running, the difference is the fill level
+    static inline std::uint16_t head{};
+    static inline std::uint16_t tail{};
+    static inline std::uint16_t highWater{};
+
+    static constexpr std::uint16_t indexMask = Capacity - 1;
+
+public:
+    // callable from any priority, false if the queue is full
+    [[nodiscard]] static bool post(Work  work,
+                                   void* arg = nullptr) {
+        bool wasEmpty;
+        {
+            CriticalSection     cs;
+            std::uint16_t const used = std::uint16_t(head - tail);
+            if(used == Capacity) { return false; }
+            items[head & indexMask] = Item{work, arg};
+            head                    = std::uint16_t(head + 1U);
+            wasEmpty                = used == 0;
+            if(used + 1U > highWater) { highWater = std::uint16_t(used + 1U); }
+        }
+        // an already pending or running drain picks the item up
+        if(wasEmpty) { apply(write(ScbRegs::ICSR::PENDSVSETValC::set_pending)); }
+        return true;
+    }
+
+    // runs work until the queue is empty, including work posted meanwhile
+    static void drain() {
+        while(true) {
+            Item item;
+            {
+                CriticalSection cs;
+                if(head == tail) { return; }
+                item = items[tail & indexMask];
+                tail = std::uint16_t(tail + 1U);
+            }
+            item.work(item.arg);
+        }
+    }
+
+    // most items queued at once since reset, to size Capacity
+    static std::size_t maxUsed() { return highWater; }
+
+    static constexpr auto initStepInterruptConfig
+      = list(action(Nvic::Action::setPriority3, Interrupt::pendSV),
+             action(Nvic::Action::clearPending, Interrupt::pendSV));
+
+    static constexpr Nvic::Isr<std::addressof(drain), std::decay_t<decltype(Interrupt::pendSV)>>
+      isr{};
+};
+
+}   // namespace Kvasir::Core
@@ -0,0 +1,318 @@
+#pragma once
+
+#include "CriticalSection.hpp"
+#include "SystemControl.hpp"
+#include "kvasir/Common/Interrupt.hpp"
+
+#include <array>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace Kvasir::Executor {
+
+// static memory for one coroutine frame, passed as first argument of the coroutine:
+//
+//   Kvasir::Executor::Task blink(Kvasir::Executor::TaskStorageBase&, Led& led) { ... }
+//   static Kvasir::Executor::TaskStorage<128> blinkStorage;
+//   Exec::spawn(blink(blinkStorage, led));
+//
+// the frame size is only known to the compiler, a too small storage makes the Task empty
+// (spawn() returns false) instead of using the heap, one storage holds one running coroutine
+struct TaskStorageBase {
+    std::byte*  memory;
+    std::size_t size;
+    bool        inUse;
+};
+
+namespace Detail {
+    // a base of TaskStorage so it is constructed before TaskStorageBase points into it
+    template<std::size_t Bytes>
+    struct FrameBuffer {
+        alignas(8) std::array<std::byte, Bytes> buffer{};
+    };
+}   // namespace Detail
+
+template<std::size_t Bytes>
+struct TaskStorage
+  : private Detail::FrameBuffer<Bytes>
+  , TaskStorageBase {
+    constexpr TaskStorage() : TaskStorageBase{this->buffer.data(), Bytes, false} {}
+
+    TaskStorage(TaskStorage const&)            = delete;
+    TaskStorage& operator=(TaskStorage const&) = delete;
+};
+
+struct Task;
+
+struct Promise {
+    // the storage pointer is kept in front of the frame for operator delete
+    static constexpr std::size_t header = 8;
+
+    template<typename... Args>
+    static void* operator new(std::size_t      size,
+                              TaskStorageBase& storage,
+                              Args&...) noexcept {
+        if(storage.inUse || size + header > storage.size) { return nullptr; }
+        storage.inUse                                      = true;
+        *reinterpret_cast<TaskStorageBase**>(storage.memory) = &storage;
+        return storage.memory + header;
+    }
+
+    static void operator delete(void*       frame,
+                                std::size_t) noexcept {
+        auto* const memory = static_cast<std::byte*>(frame) - header;
+        (*reinterpret_cast<TaskStorageBase**>(memory))->inUse = false;
+    }
+
+    static Task get_return_object_on_allocation_failure();
+    Task        get_return_object();
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    // the frame frees its storage on completion, nothing refers to it anymore
+    std::suspend_never final_suspend() noexcept { return {}; }
+
+    void return_void() {}
+
+    void unhandled_exception() { __builtin_trap(); }
+
+    std::coroutine_handle<Promise> handle() {
+        return std::coroutine_handle<Promise>::from_promise(*this);
+    }
+
+    Promise*      next{};
+    std::uint64_t deadline{};
+};
+
+// a not yet started coroutine, empty if its storage was too small or in use
+struct Task {
+    using promise_type = Promise;
+
+    explicit operator bool() const { return promise != nullptr; }
+
+    Promise* promise{};
+};
+
+inline Task Promise::get_return_object_on_allocation_failure() { return Task{}; }
+
+inline Task Promise::get_return_object() { return Task{this}; }
+
+// set from an ISR, awaited by one coroutine at a time, signal() is two byte stores so it needs
+// no masking and costs a few cycles in the ISR
+struct Event {
+    void signal() {
+        fired   = true;
+        pending = true;
+    }
+
+private:
+    template<typename>
+    friend struct Executor;
+
+    static inline volatile bool pending{};
+
+    volatile bool fired{};
+    Promise*      waiter{};
+    Event*        next{};
+};
+
+// single stack cooperative executor for coroutines, Clock has to be a tickless
+// SystickClockBase so sleeping coroutines wake exactly at their deadline
+//
+// run() resumes the ready coroutines in FIFO order, then moves coroutines whose event fired or
+// deadline passed to the ready queue and sleeps in WFI when nothing is runnable
+// a resume/suspend pair is a queue pop, an indirect call into the frame and a queue push,
+// about 30 cycles on M0+ counted from the code, sleeping adds the deadline insert
+template<typename Clock>
+struct Executor {
+private:
+    static_assert(Clock::tickless, "the executor needs a tickless clock to sleep until deadlines");
+
+    using time_point = typename Clock::time_point;
+    using duration   = typename Clock::duration;
+    using rep        = typename Clock::rep;
+
+    // only touched from thread mode, ISRs only use Event::signal()
+    static inline Promise* readyHead{};
+    static inline Promise* readyTail{};
+    static inline Promise* sleeping{};   // sorted by deadline
+    static inline Event*   waiting{};
+
+    static void makeReady(Promise& p) {
+        p.next = nullptr;
+        if(readyTail == nullptr) {
+            readyHead = &p;
+        } else {
+            readyTail->next = &p;
+        }
+        readyTail = &p;
+    }
+
+    static Promise* popReady() {
+        Promise* const p = readyHead;
+        if(p != nullptr) {
+            readyHead = p->next;
+            if(readyHead == nullptr) { readyTail = nullptr; }
+        }
+        return p;
+    }
+
+    static std::uint64_t ticks(time_point t) { return std::uint64_t(t.time_since_epoch().count()); }
+
+    static void wakeEvents() {
+        if(!Event::pending) { return; }
+        Event::pending = false;
+        Event** link   = &waiting;
+        while(*link != nullptr) {
+            Event* const e = *link;
+            if(e->fired) {
+                e->fired = false;
+                *link    = e->next;
+                makeReady(*e->waiter);
+                e->waiter = nullptr;
+            } else {
+                link = &e->next;
+            }
+        }
+    }
+
+    static void wakeTimers() {
+        if(sleeping == nullptr) { return; }
+        std::uint64_t const now = ticks(Clock::now());
+        while(sleeping != nullptr && sleeping->deadline <= now) {
+            Promise* const p = sleeping;
+            sleeping         = p->next;
+            makeReady(*p);
+        }
+    }
+
+    static void idle() {
+        Core::CriticalSection cs;
+        if(readyHead != nullptr || Event::pending) { return; }
+        if(sleeping != nullptr) {
+            if(sleeping->deadline <= ticks(Clock::now())) { return; }
+            Clock::requestDeadline(time_point{duration{rep(sleeping->deadline)}});
+        }
+        // wakes on the pending interrupt even with PRIMASK set, it runs when cs ends
+        SystemControl::waitForInterrupt();
+    }
+
+public:
+    // queues a coroutine, false if the task is empty (storage too small or in use)
+    static bool spawn(Task task) {
+        if(!task) { return false; }
+        makeReady(*task.promise);
+        return true;
+    }
+
+    [[noreturn]] static void run() {
+        while(true) {
+            // only the coroutines ready at the start of the pass, the ones they make ready (a
+            // yield) wait for the next one so a coroutine yielding in a loop can not keep events
+            // and deadlines from being checked
+            if(Promise* const last = readyTail) {
+                Promise* p;
+                do {
+                    p = popReady();
+                    p->handle().resume();
+                } while(p != last);
+            }
+            wakeEvents();
+            wakeTimers();
+            if(readyHead == nullptr) { idle(); }
+        }
+    }
+
+    struct SleepAwaitable {
+        std::uint64_t deadline;
+
+        bool await_ready() const { return deadline <= ticks(Clock::now()); }
+
+        void await_suspend(std::coroutine_handle<Promise> h) const {
+            Promise& p = h.promise();
+            p.deadline = deadline;
+            Promise** link = &sleeping;
+            while(*link != nullptr && (*link)->deadline <= deadline) { link = &(*link)->next; }
+            p.next = *link;
+            *link  = &p;
+        }
+
+        void await_resume() const {}
+    };
+
+    struct EventAwaitable {
+        Event& event;
+
+        bool await_ready() const {
+            if(!event.fired) { return false; }
+            event.fired = false;
+            return true;
+        }
+
+        void await_suspend(std::coroutine_handle<Promise> h) const {
+            event.waiter = &h.promise();
+            event.next   = waiting;
+            waiting      = &event;
+        }
+
+        void await_resume() const {}
+    };
+
+    struct YieldAwaitable {
+        bool await_ready() const { return false; }
+
+        void await_suspend(std::coroutine_handle<Promise> h) const { makeReady(h.promise()); }
+
+        void await_resume() const {}
+    };
+
+    static SleepAwaitable sleepUntil(time_point t) { return {ticks(t)}; }
+
+    static SleepAwaitable sleepFor(duration d) { return {ticks(Clock::now() + d)}; }
+
+    template<typename Rep,
+             typename Period>
+    static SleepAwaitable sleepFor(std::chrono::duration<Rep, Period> d) {
+        return sleepFor(Clock::fromDuration(d));
+    }
+
+    static EventAwaitable wait(Event& e) { return {e}; }
+
+    static YieldAwaitable yield() { return {}; }
+};
+
+// "interrupt I fired" as an awaitable, awaiting enables I in the NVIC, the ISR disables it again
+// and signals, so a level triggered peripheral interrupt does not storm until the coroutine ran
+// and cleared the peripheral flag
+template<typename I>
+struct InterruptEvent {
+private:
+    static inline Event event{};
+
+    static void onIsr() {
+        apply(makeDisable(I{}));
+        event.signal();
+    }
+
+    template<typename Clock>
+    struct Awaitable : Executor<Clock>::EventAwaitable {
+        void await_suspend(std::coroutine_handle<Promise> h) const {
+            Executor<Clock>::EventAwaitable::await_suspend(h);
+            apply(makeEnable(I{}));
+        }
+    };
+
+public:
+    template<typename Clock>
+    static Awaitable<Clock> wait() {
+        return Awaitable<Clock>{{event}};
+    }
+
+    static constexpr Nvic::Isr<std::addressof(onIsr), I> isr{};
+};
+
+}   // namespace Kvasir::Executor
@@ -1,4 +1,5 @@
 #pragma once
+#include "Backtrace.hpp"
 #include "core_peripherals/SCB.hpp"
 #include "kvasir/Register/Register.hpp"
 
@@ -110,4 +111,19 @@ static inline void Log([[maybe_unused]] std::uint32_t const* stack_ptr,
       lr_value);
 }
 
+// addresses are printed as they are stored, a zero marks an unused entry
+static inline void LogBacktrace([[maybe_unused]] Backtrace const& trace) {
+    UC_LOG_C("COREFAULT backtrace({}) {:#08x} {:#08x} {:#08x} {:#08x} {:#08x} {:#08x} {:#08x} "
+             "{:#08x}",
+             trace.count,
+             trace.addresses[0],
+             trace.addresses[1],
+             trace.addresses[2],
+             trace.addresses[3],
+             trace.addresses[4],
+             trace.addresses[5],
+             trace.addresses[6],
+             trace.addresses[7]);
+}
+
 };   // namespace Kvasir::Core::Fault
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "CriticalSection.hpp"
+#include "SystemControl.hpp"
+
+#include <cstdint>
+
+namespace Kvasir::Systick::Host {
+
+// host model of SYSTICK and the Systick bits of SCB, used as Config::hardware to run the
+// timing code of SystickClockBase off target:
+//
+//   struct Cfg { ...; using hardware = Kvasir::Systick::Host::SimulatedSystick<>; };
+//   using Clock = Kvasir::Systick::SystickClockBase<Cfg>;
+//   Model::reset(Clock::isrFunction);
+//
+// every register access advances the simulated counter by cyclesPerAccess, reaching 0 sets
+// COUNTFLAG and the pending bit and runs the ISR right away unless interrupts are masked (then
+// on unmask, as the hardware would), injectAt() runs a function between two accesses to force a
+// race window, e.g. a wrap between reading CVR and reading the pending bit
+// modeled are CSR.COUNTFLAG (clear on read and on a CVR write), CSR.TICKINT, ICSR.PENDSTSET and
+// PENDSTCLR, Systick is an exception without NVIC enable/pending bits and with a single
+// interrupt its SHPR3 priority does not matter, so neither is modeled
+// tests/SystickTest.cpp drives SystickClockBase through it
+//
+// only available in host builds, CriticalSection and waitForInterrupt have host variants there
+template<typename Tag = void>
+struct SimulatedSystick {
+    static inline std::uint32_t reload{(1U << 24U) - 1U};
+    static inline std::uint32_t current{};
+    static inline bool          pending{};
+    static inline bool          countFlag{};
+    static inline bool          tickInt{true};
+    static inline bool          inIsr{};
+    static inline std::uint64_t cycles{};
+    static inline std::uint64_t accesses{};
+    static inline std::uint32_t cyclesPerAccess{1};
+    static inline std::uint64_t isrCount{};
+    static inline void (*handler)(){};
+    static inline std::uint64_t injectAccess{};
+    static inline void (*injection)(){};
+
+    static void reset(void (*isr)(),
+                      std::uint32_t reloadValue = (1U << 24U) - 1U) {
+        reload          = reloadValue;
+        current         = 0;
+        pending         = false;
+        countFlag       = false;
+        tickInt         = true;
+        inIsr           = false;
+        cycles          = 0;
+        accesses        = 0;
+        cyclesPerAccess = 1;
+        isrCount        = 0;
+        handler         = isr;
+        injection       = nullptr;
+
+        Core::HostDetail::primask         = false;
+        Core::HostDetail::onUnmask        = &deliver;
+        SystemControl::HostDetail::onWait = &waitForInterrupt;
+    }
+
+    // runs f right before the n-th register access from now
+    static void injectAt(std::uint64_t n,
+                         void (*f)()) {
+        injectAccess = accesses + n;
+        injection    = f;
+    }
+
+    // as the hardware, every cycle a count of 0 (after reaching it or after a CVR write)
+    // reloads from RVR, any other count decrements and reaching 0 sets COUNTFLAG and with
+    // TICKINT pends the interrupt, several periods pass as one pending interrupt
+    static void advance(std::uint64_t n) {
+        cycles += n;
+        while(n != 0) {
+            if(current == 0) {
+                current = reload;
+                --n;
+            } else if(n < current) {
+                current -= std::uint32_t(n);
+                n = 0;
+            } else {
+                n -= current;
+                current   = 0;
+                pending   = pending || tickInt;
+                countFlag = true;
+                if(reload != 0 && n > std::uint64_t(reload) + 1U) {
+                    // whole periods only end on 0 again
+                    n -= (n - 1U) / (std::uint64_t(reload) + 1U) * (std::uint64_t(reload) + 1U);
+                }
+            }
+        }
+        deliver();
+    }
+
+    // cycles until the count reaches 0 next
+    static std::uint64_t cyclesToZero() {
+        return current == 0 ? std::uint64_t(reload) + 1U : current;
+    }
+
+    // takes a pending Systick if interrupts are enabled
+    static void deliver() {
+        while(pending && !inIsr && !Core::HostDetail::primask && handler != nullptr) {
+            pending = false;
+            inIsr   = true;
+            ++isrCount;
+            handler();
+            inIsr = false;
+        }
+    }
+
+    // WFI, sleeps until the count reaches 0
+    static void waitForInterrupt() {
+        if(!pending) { advance(cyclesToZero()); }
+    }
+
+    // SYSTICK CSR.COUNTFLAG, cleared by reading
+    static bool readCountFlag() {
+        access();
+        bool const flag = countFlag;
+        countFlag       = false;
+        return flag;
+    }
+
+    // SYSTICK CSR.TICKINT, without it reaching 0 only sets COUNTFLAG
+    static void setTickInt(bool enabled) {
+        access();
+        tickInt = enabled;
+    }
+
+    // SCB ICSR.PENDSTSET, the ISR runs as soon as interrupts are enabled
+    static void setPending() {
+        access();
+        pending = true;
+        deliver();
+    }
+
+    // SCB ICSR.PENDSTCLR
+    static void clearPending() {
+        access();
+        pending = false;
+    }
+
+    // Config::hardware interface
+    static std::uint32_t currentCount() {
+        access();
+        return current;
+    }
+
+    static bool wrapPending() {
+        access();
+        return pending;
+    }
+
+    static void setReload(std::uint32_t value) {
+        access();
+        reload = value & 0x00FF'FFFFU;
+    }
+
+    static void clearCount() {
+        access();
+        current   = 0;
+        countFlag = false;
+    }
+
+private:
+    static void access() {
+        if(injection != nullptr && accesses == injectAccess) {
+            auto const f = injection;
+            injection    = nullptr;
+            f();
+        }
+        ++accesses;
+        advance(cyclesPerAccess);
+    }
+};
+
+}   // namespace Kvasir::Systick::Host
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "CriticalSection.hpp"
+#include "core_peripherals/SCB.hpp"
+#include "core_peripherals/SYSTICK.hpp"
+#include "kvasir/Common/Interrupt.hpp"
+#include "kvasir/Register/Register.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace Kvasir::Nvic {
+
+// timing of one instrumented ISR in Systick ticks, time spent in ISRs that preempted it (and are
+// instrumented as well) is not counted, histogram[i] counts runs of [2^i, 2^(i+1)) ticks with
+// runs shorter than 2 ticks in bin 0 and everything from 2^15 ticks up in the last bin
+struct IsrStats {
+    static constexpr std::size_t bins = 16;
+
+    std::uint32_t                   count{};
+    std::uint32_t                   min{std::numeric_limits<std::uint32_t>::max()};
+    std::uint32_t                   max{};
+    std::uint64_t                   total{};
+    std::uint32_t                   preempting{};   // runs that interrupted another ISR
+    std::uint32_t                   maxLatency{};   // Systick only, ticks from wrap to entry
+    std::uint8_t                    vector{};       // ICSR.VECTACTIVE, 16 + IRQ number
+    std::array<std::uint32_t, bins> histogram{};
+};
+
+namespace Detail {
+    // ticks spent in instrumented ISRs nested into each active level, M0+ has 4 priority levels
+    // plus thread mode, updated with interrupts masked as a handler preempting between reading
+    // and writing depth would take the same level
+    struct IsrNesting {
+        static inline std::uint8_t                 depth{};
+        static inline std::array<std::uint32_t, 6> nested{};
+    };
+
+    // bin of floor(log2(ticks)) by binary search, ARMv6-M has no CLZ
+    static constexpr std::size_t log2Bin(std::uint32_t ticks) {
+        std::size_t bin = 0;
+        if(ticks >= (1U << 8U)) {
+            ticks >>= 8U;
+            bin += 8;
+        }
+        if(ticks >= (1U << 4U)) {
+            ticks >>= 4U;
+            bin += 4;
+        }
+        if(ticks >= (1U << 2U)) {
+            ticks >>= 2U;
+            bin += 2;
+        }
+        if(ticks >= (1U << 1U)) { bin += 1; }
+        return bin < IsrStats::bins ? bin : IsrStats::bins - 1;
+    }
+}   // namespace Detail
+
+// wraps F with entry/exit timestamps from Systick CVR, use function in place of F:
+//
+//   static constexpr Nvic::Isr<Nvic::Instrumented<std::addressof(onUart)>::function,
+//                              std::decay_t<decltype(Interrupt::usart0)>> isr{};
+//
+// with Enabled false function is F itself, no code and no RAM is added
+// enabled the wrapper costs about 60 cycles per run (3 CVR/RVR loads, VECTACTIVE, two short
+// PRIMASK sections for the nesting bookkeeping, the stats update and the histogram search) and
+// about 100 bytes RAM per ISR, estimated from the code as there is no cycle counter on M0+
+//
+// Systick has to run with the interrupt instrumented ISRs should be measured against, runs
+// longer than one Systick period are measured modulo the period
+template<void (*F)(),
+         bool Enabled = true>
+struct Instrumented {
+private:
+    using SystickRegs = Kvasir::Peripheral::SYSTICK::Registers<>;
+    using ScbRegs     = Kvasir::Peripheral::SCB::Registers<>;
+
+    static std::uint32_t cvr() { return std::uint32_t(apply(read(SystickRegs::CVR::current))); }
+
+    static void handler() {
+        auto const    vector = std::uint8_t(apply(read(ScbRegs::ICSR::vectactive)));
+        std::uint32_t start;
+        std::uint8_t  level;
+        {
+            // masked up to the start timestamp, so a handler preempting here is accounted to
+            // the level below and not in the elapsed time of this one
+            Core::CriticalSection cs;
+            level = Detail::IsrNesting::depth;
+            if(level < Detail::IsrNesting::nested.size()) { Detail::IsrNesting::nested[level] = 0; }
+            Detail::IsrNesting::depth = std::uint8_t(level + 1U);
+            start                     = cvr();
+        }
+        bool const inside = level < Detail::IsrNesting::nested.size();
+
+        F();
+
+        std::uint32_t elapsed;
+        std::uint32_t nested;
+        std::uint32_t reload;
+        {
+            // masked from the end timestamp on, so a handler preempting here is neither in
+            // elapsed nor in nested and can not interleave with the update of the parent level
+            Core::CriticalSection cs;
+            std::uint32_t const   end = cvr();
+            reload                    = std::uint32_t(apply(read(SystickRegs::RVR::reload)));
+            // CVR counts down and wraps from 0 to reload
+            elapsed = end <= start ? start - end : start + reload + 1U - end;
+            nested  = inside ? Detail::IsrNesting::nested[level] : 0U;
+            Detail::IsrNesting::depth = level;
+            if(level != 0 && level - 1U < Detail::IsrNesting::nested.size()) {
+                Detail::IsrNesting::nested[level - 1U] += elapsed;
+            }
+        }
+        std::uint32_t const own = elapsed > nested ? elapsed - nested : 0U;
+
+        stats.vector = vector;
+        ++stats.count;
+        if(own < stats.min) { stats.min = own; }
+        if(own > stats.max) { stats.max = own; }
+        stats.total += own;
+        if(level != 0) { ++stats.preempting; }
+        ++stats.histogram[Detail::log2Bin(own)];
+        if(vector == 15) {
+            std::uint32_t const latency = reload - start;
+            if(latency > stats.maxLatency) { stats.maxLatency = latency; }
+        }
+    }
+
+public:
+    // only ever written by the handler
+    static inline IsrStats stats{};
+
+    static constexpr void (*function)() = [] {
+        if constexpr(Enabled) {
+            return &handler;
+        } else {
+            return F;
+        }
+    }();
+};
+
+}   // namespace Kvasir::Nvic
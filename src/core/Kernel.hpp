@@ -0,0 +1,250 @@
+#pragma once
+
+#include "CriticalSection.hpp"
+#include "SystemControl.hpp"
+#include "core_peripherals/SCB.hpp"
+#include "kvasir/Common/Interrupt.hpp"
+#include "kvasir/Register/Register.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+// defined at the end of this file, see Scheduler::start()
+extern "C" inline std::uint32_t* kvasirKernelSwitchContext(std::uint32_t* sp);
+
+namespace Kvasir::Kernel {
+
+struct TaskControlBlock {
+    std::uint32_t*    sp{};
+    TaskControlBlock* next{};
+    TaskControlBlock* prev{};
+    std::uint8_t      priority{};
+    bool              ready{};
+};
+
+// static storage for one task, StackWords has to hold the deepest call chain of the task plus
+// 16 words of saved context, interrupts run on the main stack
+template<std::size_t StackWords>
+struct Task {
+    static_assert(StackWords >= 32, "stack to small for the saved context");
+
+    TaskControlBlock                               tcb{};
+    alignas(8) std::array<std::uint32_t, StackWords> stack{};
+};
+
+namespace Detail {
+    // position of the lowest set bit in O(1), ARMv6-M has neither CLZ nor RBIT
+    static constexpr std::uint32_t lowestBit(std::uint32_t x) {
+        constexpr std::array<std::uint8_t, 32> debruijn{0,  1,  28, 2,  29, 14, 24, 3,
+                                                        30, 22, 20, 15, 25, 17, 4,  8,
+                                                        31, 27, 13, 23, 21, 19, 16, 7,
+                                                        26, 12, 18, 6,  11, 5,  10, 9};
+        return debruijn[((x & (~x + 1U)) * 0x077C'B531U) >> 27U];
+    }
+}   // namespace Detail
+
+// fixed priority preemptive kernel switching tasks from PendSV
+// priority 0 is the most urgent, tasks of equal priority are time sliced round robin by
+// timeSlice() from the Systick ISR, the scheduler is a ready bitmap plus one circular list per
+// priority so every decision is O(1)
+//
+// PendSV has to run at the lowest priority (see initStepInterruptConfig) so a switch never
+// preempts an ISR, the switch saves r4-r11 on the task stack (r8-r11 through the low registers
+// as ARMv6-M cannot push high registers) and costs about 60 cycles plus exception entry/exit
+struct Scheduler {
+    static constexpr std::uint8_t priorities   = 32;
+    static constexpr std::uint8_t idlePriority = priorities - 1;
+
+private:
+    using ScbRegs = Kvasir::Peripheral::SCB::Registers<>;
+
+    static inline std::array<TaskControlBlock*, priorities> readyLists{};
+    static inline std::uint32_t                             readyMask{};
+    static inline TaskControlBlock*                         current{};
+    static inline Task<48>                                  idle{};
+    // PSP target for the registers "saved" by the very first switch
+    static inline std::array<std::uint32_t, 8> startupScratch{};
+
+    static void pendSwitch() { apply(write(ScbRegs::ICSR::PENDSVSETValC::set_pending)); }
+
+    // interrupts masked for all list operations
+    static void makeReady(TaskControlBlock& t) {
+        if(t.ready) { return; }
+        TaskControlBlock*& head = readyLists[t.priority];
+        if(head == nullptr) {
+            t.next = &t;
+            t.prev = &t;
+            head   = &t;
+        } else {
+            t.next          = head;
+            t.prev          = head->prev;
+            head->prev->next = &t;
+            head->prev       = &t;
+        }
+        readyMask |= 1U << t.priority;
+        t.ready = true;
+    }
+
+    static void makeBlocked(TaskControlBlock& t) {
+        if(!t.ready) { return; }
+        TaskControlBlock*& head = readyLists[t.priority];
+        if(t.next == &t) {
+            head = nullptr;
+            readyMask &= ~(1U << t.priority);
+        } else {
+            t.prev->next = t.next;
+            t.next->prev = t.prev;
+            if(head == &t) { head = t.next; }
+        }
+        t.ready = false;
+    }
+
+    static void reschedule() {
+        if(current == nullptr) { return; }
+        TaskControlBlock* const next = readyLists[Detail::lowestBit(readyMask)];
+        if(next != current) { pendSwitch(); }
+    }
+
+    static void exitTask() {
+        suspend(*current);
+        while(true) {}
+    }
+
+    static void idleTask(void*) {
+        while(true) { SystemControl::waitForInterrupt(); }
+    }
+
+public:
+    // interrupts are masked by the PendSV handler
+    static std::uint32_t* switchContext(std::uint32_t* sp) {
+        if(current != nullptr) { current->sp = sp; }
+        current = readyLists[Detail::lowestBit(readyMask)];
+        return current->sp;
+    }
+
+    [[gnu::naked]] static void pendSvHandler() {
+        asm volatile("mrs r0, psp\n\t"
+                     "subs r0, #32\n\t"
+                     "stmia r0!, {r4-r7}\n\t"
+                     "mov r4, r8\n\t"
+                     "mov r5, r9\n\t"
+                     "mov r6, r10\n\t"
+                     "mov r7, r11\n\t"
+                     "stmia r0!, {r4-r7}\n\t"
+                     "subs r0, #32\n\t"
+                     "cpsid i\n\t"
+                     "bl kvasirKernelSwitchContext\n\t"
+                     "cpsie i\n\t"
+                     "adds r0, #16\n\t"
+                     "ldmia r0!, {r4-r7}\n\t"
+                     "mov r8, r4\n\t"
+                     "mov r9, r5\n\t"
+                     "mov r10, r6\n\t"
+                     "mov r11, r7\n\t"
+                     "msr psp, r0\n\t"
+                     "subs r0, #32\n\t"
+                     "ldmia r0!, {r4-r7}\n\t"
+                     // EXC_RETURN thread mode, process stack
+                     "movs r3, #2\n\t"
+                     "mvns r3, r3\n\t"
+                     "bx r3\n\t");
+    }
+
+    template<std::size_t StackWords>
+    static void create(Task<StackWords>& task,
+                       void (*entry)(void*),
+                       void*        arg,
+                       std::uint8_t priority) {
+        static_assert(StackWords % 2 == 0, "stack has to stay 8 byte aligned");
+        // hardware frame r0-r3, r12, lr, pc, xPSR below 8 words of software saved r4-r11
+        std::uint32_t* const top = task.stack.data() + task.stack.size();
+        std::uint32_t* const sp  = top - 16;
+        sp[8]                    = std::uint32_t(reinterpret_cast<std::uintptr_t>(arg));
+        sp[13]                   = std::uint32_t(reinterpret_cast<std::uintptr_t>(&exitTask));
+        sp[14]                   = std::uint32_t(reinterpret_cast<std::uintptr_t>(entry)) & ~1U;
+        sp[15]                   = 1U << 24U;   // Thumb state
+        task.tcb.sp              = sp;
+        task.tcb.priority        = priority < idlePriority ? priority : idlePriority;
+
+        Core::CriticalSection cs;
+        makeReady(task.tcb);
+        reschedule();
+    }
+
+    // callable from tasks and ISRs
+    static void suspend(TaskControlBlock& t) {
+        Core::CriticalSection cs;
+        makeBlocked(t);
+        reschedule();
+    }
+
+    static void resume(TaskControlBlock& t) {
+        Core::CriticalSection cs;
+        makeReady(t);
+        reschedule();
+    }
+
+    // gives the rest of the slice to the next task of the same priority
+    static void yield() {
+        Core::CriticalSection cs;
+        if(current == nullptr || !current->ready) { return; }
+        readyLists[current->priority] = current->next;
+        reschedule();
+    }
+
+    static TaskControlBlock* self() { return current; }
+
+    // round robin for the running priority, call from Config::onTick() of the clock, with a
+    // tickless clock the next slice end is requested as deadline
+    template<typename Clock>
+    static void timeSlice(typename Clock::duration slice) {
+        static typename Clock::time_point sliceEnd{};
+        auto const                        now = Clock::now();
+        bool                              shared;
+        {
+            Core::CriticalSection cs;
+            if(current == nullptr || !current->ready) { return; }
+            shared = current->next != current;
+            if(shared && now >= sliceEnd) {
+                readyLists[current->priority] = current->next;
+                reschedule();
+            }
+        }
+        if(now >= sliceEnd) { sliceEnd = now + slice; }
+        if constexpr(Clock::tickless) {
+            if(shared) { Clock::requestDeadline(sliceEnd); }
+        }
+    }
+
+    // switches to the most urgent task, never returns
+    [[noreturn]] static void start() {
+        // the naked PendSV handler calls kvasirKernelSwitchContext by name, which the compiler
+        // can not see, this reference emits it (and the scheduler state) only in programs that
+        // start the kernel
+        asm volatile("" ::"r"(&kvasirKernelSwitchContext));
+        create(idle, &idleTask, nullptr, idlePriority);
+        asm volatile("msr psp, %0\n\t"
+                     "isb" ::"r"(startupScratch.data() + startupScratch.size())
+                     : "memory");
+        pendSwitch();
+        asm volatile("cpsie i" ::: "memory");
+        while(true) {}
+    }
+
+    static constexpr auto initStepInterruptConfig
+      = list(action(Nvic::Action::setPriority3, Interrupt::pendSV));
+
+    static constexpr Nvic::Isr<std::addressof(pendSvHandler),
+                               std::decay_t<decltype(Interrupt::pendSV)>>
+      isr{};
+};
+
+}   // namespace Kvasir::Kernel
+
+// called by name from the naked PendSV handler
+extern "C" inline std::uint32_t* kvasirKernelSwitchContext(std::uint32_t* sp) {
+    return Kvasir::Kernel::Scheduler::switchContext(sp);
+}
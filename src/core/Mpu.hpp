@@ -0,0 +1,150 @@
+#pragma once
+
+#include "core_peripherals/MPU.hpp"
+#include "kvasir/Register/Register.hpp"
+
+#include <cstdint>
+#include <initializer_list>
+
+namespace Kvasir::Mpu {
+using MpuRegs = Kvasir::Peripheral::MPU::Registers<>;
+
+// RASR.AP, privileged / unprivileged access
+enum class Access : std::uint8_t {
+    none                 = 0b000,
+    privilegedReadWrite  = 0b001,
+    unprivilegedReadOnly = 0b010,
+    readWrite            = 0b011,
+    privilegedReadOnly   = 0b101,
+    readOnly             = 0b110,
+};
+
+// RASR.TEX/S/C/B encodings usable on Cortex-M0+
+enum class Memory : std::uint8_t {
+    stronglyOrdered,
+    device,
+    normal,          // write-through, as usual for flash
+    normalShared,    // write-through, shared
+    normalNoCache,
+};
+
+namespace Detail {
+    static constexpr bool isPowerOfTwo(std::uint64_t v) { return v != 0 && (v & (v - 1)) == 0; }
+
+    static constexpr std::uint32_t log2(std::uint64_t v) {
+        std::uint32_t r = 0;
+        while(v > 1) {
+            v >>= 1U;
+            ++r;
+        }
+        return r;
+    }
+
+    // RASR[31:16] as written to the attrs field, XN is bit 28
+    static constexpr std::uint32_t attributes(Access a,
+                                              Memory m,
+                                              bool   execute) {
+        std::uint32_t texScb{};
+        switch(m) {
+        case Memory::stronglyOrdered: texScb = 0b000'0'0'0; break;
+        case Memory::device: texScb = 0b000'1'0'1; break;
+        case Memory::normal: texScb = 0b000'0'1'0; break;
+        case Memory::normalShared: texScb = 0b000'1'1'0; break;
+        case Memory::normalNoCache: texScb = 0b001'0'0'0; break;
+        }
+        return (execute ? 0U : 1U << 12U) | (std::uint32_t(a) << 8U) | texScb;
+    }
+}   // namespace Detail
+
+// one MPU region, everything is checked at compile time:
+// - ARMv6-M has 8 regions of 256 bytes up to 4 GiB, sizes are powers of two
+// - Base has to be aligned to Size
+// - DisabledSubregions (RASR.SRD) masks eighths of the region
+template<std::uint32_t Number,
+         std::uint32_t Base,
+         std::uint64_t Size,
+         Access        A,
+         Memory        M                  = Memory::normal,
+         bool          Execute            = true,
+         std::uint8_t  DisabledSubregions = 0>
+struct Region {
+    static_assert(Number < 8, "cortex_m0plus has 8 MPU regions");
+    static_assert(Detail::isPowerOfTwo(Size) && Size >= 256 && Size <= (1ULL << 32U),
+                  "region size has to be a power of two from 256 bytes to 4GiB");
+    static_assert(Base % Size == 0, "region base has to be aligned to the region size");
+    static_assert(DisabledSubregions != 0xFF, "all subregions disabled, region has no effect");
+
+    static constexpr std::uint32_t number = Number;
+    static constexpr std::uint32_t base   = Base;
+    static constexpr std::uint64_t size   = Size;
+
+    // RBAR.VALID selects the region with the same write, no RNR write needed
+    // the sequence points keep RBAR before RASR and regions from being merged
+    static constexpr auto config
+      = list(Register::sequencePoint,
+             write(MpuRegs::RBAR::addr, Register::value<(Base >> 5U)>()),
+             write(MpuRegs::RBAR::valid, Register::value<1>()),
+             write(MpuRegs::RBAR::region, Register::value<Number>()),
+             Register::sequencePoint,
+             write(MpuRegs::RASR::attrs, Register::value<Detail::attributes(A, M, Execute)>()),
+             write(MpuRegs::RASR::srd, Register::value<DisabledSubregions>()),
+             write(MpuRegs::RASR::size, Register::value<Detail::log2(Size) - 1>()),
+             write(MpuRegs::RASR::enable, Register::value<1>()),
+             Register::sequencePoint);
+};
+
+// smallest possible no-access, no-execute region at the lowest address of a stack growing down,
+// an overflow into it faults in hardware (escalated to HardFault on M0+) instead of silently
+// corrupting the memory below, which replaces stack painting and canary checks
+// StackBottom has to be 256 byte aligned, the guard costs the lowest 256 bytes of the stack
+template<std::uint32_t Number,
+         std::uint32_t StackBottom>
+using StackGuard = Region<Number, StackBottom, 256, Access::none, Memory::normal, false>;
+
+// same as StackGuard for a stack bottom only known at link time (e.g. a linker symbol), the
+// guard is placed at the first 256 byte boundary at or above stackBottom
+template<std::uint32_t Number>
+static void guardStack(std::uint32_t stackBottom) {
+    static_assert(Number < 8, "cortex_m0plus has 8 MPU regions");
+    std::uint32_t const base = (stackBottom + 255U) & ~255U;
+    apply(write(MpuRegs::RBAR::addr, base >> 5U),
+          write(MpuRegs::RBAR::valid, Register::value<1>()),
+          write(MpuRegs::RBAR::region, Register::value<Number>()));
+    apply(write(MpuRegs::RASR::attrs,
+                Register::value<Detail::attributes(Access::none, Memory::normal, false)>()),
+          write(MpuRegs::RASR::srd, Register::value<0>()),
+          write(MpuRegs::RASR::size, Register::value<7>()),
+          write(MpuRegs::RASR::enable, Register::value<1>()));
+    asm volatile("dsb\n\t"
+                 "isb" ::
+                   : "memory");
+}
+
+// kvasir init steps for a set of regions, the background map stays the privileged default
+// (PRIVDEFENA) so only the listed regions restrict access
+template<typename... Regions>
+struct Config {
+private:
+    static constexpr bool uniqueNumbers() {
+        std::uint32_t seen{};
+        for(std::uint32_t const n : {Regions::number...}) {
+            if((seen >> n) & 1U) { return false; }
+            seen |= 1U << n;
+        }
+        return true;
+    }
+
+    static_assert(sizeof...(Regions) != 0, "an MPU config needs at least one region");
+    static_assert(uniqueNumbers(), "every MPU region number can only be used once");
+
+public:
+    static constexpr auto initStepPeripheryConfig
+      = list(write(MpuRegs::CTRL::enable, Register::value<0>()), Regions::config...);
+
+    static constexpr auto initStepPeripheryEnable
+      = list(write(MpuRegs::CTRL::privdefena, Register::value<1>()),
+             write(MpuRegs::CTRL::hfnmiena, Register::value<0>()),
+             write(MpuRegs::CTRL::enable, Register::value<1>()));
+};
+
+}   // namespace Kvasir::Mpu
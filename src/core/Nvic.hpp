@@ -1,11 +1,18 @@
 #pragma once
 
+#include "CriticalSection.hpp"
 #include "chip/Interrupt.hpp"
 #include "core_peripherals/NVIC.hpp"
 #include "kvasir/Common/Interrupt.hpp"
 #include "kvasir/Mpl/Utility.hpp"
 #include "kvasir/Register/Register.hpp"
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
 namespace Kvasir { namespace Nvic {
     namespace Detail {
         using namespace Register;
@@ -116,4 +123,289 @@ namespace Kvasir { namespace Nvic {
                                      std::end(InterruptOffsetTraits<void>::noSetPriority)),
           "Unable to set priority on this interrupt, index is out of range");
     };
+
+    namespace Detail {
+        enum class MergeKind { enable, disable, setPending, clearPending, priority };
+
+        template<typename A>
+        struct MergeKindOf;
+
+        template<>
+        struct MergeKindOf<Action::Enable> {
+            static constexpr MergeKind kind     = MergeKind::enable;
+            static constexpr unsigned  priority = 0;
+        };
+
+        template<>
+        struct MergeKindOf<Action::Disable> {
+            static constexpr MergeKind kind     = MergeKind::disable;
+            static constexpr unsigned  priority = 0;
+        };
+
+        template<>
+        struct MergeKindOf<Action::SetPending> {
+            static constexpr MergeKind kind     = MergeKind::setPending;
+            static constexpr unsigned  priority = 0;
+        };
+
+        template<>
+        struct MergeKindOf<Action::ClearPending> {
+            static constexpr MergeKind kind     = MergeKind::clearPending;
+            static constexpr unsigned  priority = 0;
+        };
+
+        template<int Priority>
+        struct MergeKindOf<Action::SetPriority<Priority>> {
+            static constexpr MergeKind kind     = MergeKind::priority;
+            static constexpr unsigned  priority = unsigned(Priority);
+        };
+
+        struct MergeEntry {
+            MergeKind kind;
+            int       index;
+            unsigned  priority;
+        };
+
+        struct MergedWrite {
+            unsigned address;
+            unsigned mask;
+            unsigned value;
+            bool     blind;   // write 1 to act register, zeros are ignored by the hardware
+        };
+
+        // one store per ISER/ICER/ISPR/ICPR and one per touched IPR word, ARMv6-M has at most
+        // 32 external interrupts so every set/clear register is a single word
+        static constexpr std::size_t maxMergedWrites = 4 + 8;
+
+        struct MergePlan {
+            std::array<MergedWrite, maxMergedWrites> writes{};
+            std::size_t                              count{};
+            bool                                     conflicting{};
+        };
+
+        template<std::size_t N>
+        constexpr MergePlan makeMergePlan(std::array<MergeEntry, N> const& entries) {
+            MergePlan                plan{};
+            std::array<unsigned, 4>  blindMasks{};
+            std::array<unsigned, 8>  priorityMasks{};
+            std::array<unsigned, 8>  priorityValues{};
+            for(auto const& e : entries) {
+                auto const bit = 1U << unsigned(e.index);
+                if(e.kind == MergeKind::priority) {
+                    auto const word  = unsigned(e.index) / 4;
+                    auto const shift = (unsigned(e.index) % 4) * 8;
+                    auto const value = (e.priority << 6U) << shift;
+                    if((priorityMasks[word] & (0xFFU << shift)) != 0
+                       && (priorityValues[word] & (0xFFU << shift)) != value)
+                    {
+                        plan.conflicting = true;
+                    }
+                    priorityMasks[word] |= 0xFFU << shift;
+                    priorityValues[word] |= value;
+                } else {
+                    blindMasks[std::size_t(e.kind)] |= bit;
+                }
+            }
+            // enable and disable (or set and clear pending) of the same interrupt depend on order
+            if((blindMasks[0] & blindMasks[1]) != 0 || (blindMasks[2] & blindMasks[3]) != 0) {
+                plan.conflicting = true;
+            }
+            auto const blind = [&](MergeKind kind) {
+                auto const reg = unsigned(kind);
+                if(blindMasks[reg] != 0) {
+                    plan.writes[plan.count++]
+                      = {baseAddress + reg * 0x080, blindMasks[reg], blindMasks[reg], true};
+                }
+            };
+            // disable and clear pending first, then priorities, enable last, so an interrupt
+            // never fires with a stale pending bit or at its old priority
+            blind(MergeKind::disable);
+            blind(MergeKind::clearPending);
+            for(unsigned word = 0; word < priorityMasks.size(); ++word) {
+                if(priorityMasks[word] != 0) {
+                    plan.writes[plan.count++] = {baseAddress + 0x300 + word * 4,
+                                                 priorityMasks[word],
+                                                 priorityValues[word],
+                                                 false};
+                }
+            }
+            blind(MergeKind::setPending);
+            blind(MergeKind::enable);
+            return plan;
+        }
+
+        template<unsigned A, unsigned Mask, unsigned Value>
+        using BlindSetMask
+          = Register::Action<WOFieldLocT<Register::Address<A, maskFromRange(31, 0)>, 31, 0>,
+                             WriteLiteralAction<Value>>;
+
+        // a fully covered IPR word needs no read, a partial one is a single read-modify-write
+        template<unsigned A, unsigned Mask, unsigned Value>
+        using PriorityWordSet = std::conditional_t<
+          Mask == maskFromRange(31, 0),
+          Register::Action<WOFieldLocT<Register::Address<A>, 31, 0>, WriteLiteralAction<Value>>,
+          Register::Action<Register::FieldLocation<Register::Address<A>, Mask, ReadWriteAccess>,
+                           WriteLiteralAction<Value>>>;
+
+        template<MergedWrite W>
+        using MergedWriteAction = std::conditional_t<W.blind,
+                                                     BlindSetMask<W.address, W.mask, W.value>,
+                                                     PriorityWordSet<W.address, W.mask, W.value>>;
+
+        // the sequence points keep the writes in plan order
+        template<MergePlan Plan, std::size_t... Is>
+        constexpr auto mergedList(std::index_sequence<Is...>) {
+            return list(list(MergedWriteAction<Plan.writes[Is]>{}, Register::sequencePoint)...);
+        }
+    }   // namespace Detail
+
+    // coalesces Enable/Disable/SetPending/ClearPending/SetPriority actions on external interrupts
+    // into one store per ISER/ICER/ISPR/ICPR and one write per IPR word (4 priorities each)
+    // independent of the argument order the writes go out as ICER, ICPR, IPR, ISPR, ISER
+    // e.g. merge(action(Action::enable, Interrupt::usart0), action(Action::setPriority1, ...))
+    // every action is still validated by its own MakeAction
+    template<typename... Actions,
+             int... Is>
+    constexpr auto merge(MakeAction<Actions, Index<Is>>...) {
+        static_assert(((Is >= 0) && ...),
+                      "core exceptions are not in the NVIC registers, keep them as separate "
+                      "actions");
+        constexpr std::array<Detail::MergeEntry, sizeof...(Is)> entries{
+          Detail::MergeEntry{Detail::MergeKindOf<Actions>::kind,
+                             Is,
+                             Detail::MergeKindOf<Actions>::priority}...};
+        constexpr Detail::MergePlan plan = Detail::makeMergePlan(entries);
+        static_assert(!plan.conflicting,
+                      "conflicting actions on the same interrupt can not be merged");
+        return Detail::mergedList<plan>(std::make_index_sequence<plan.count>{});
+    }
+
+    namespace Detail {
+        // bit i set if external interrupt i passes the same checks as the compile time actions
+        template<typename InputIt>
+        constexpr std::uint32_t validMask(InputIt f,
+                                          InputIt l) {
+            std::uint32_t mask{};
+            for(int i = 0; i < 32; ++i) {
+                if(interuptIndexValid(i, f, l)) { mask |= 1U << unsigned(i); }
+            }
+            return mask;
+        }
+
+        template<typename T>
+        constexpr std::uint32_t validMask(T const& excluded) {
+            return validMask(std::begin(excluded), std::end(excluded));
+        }
+
+        static inline volatile std::uint32_t& nvicWord(unsigned offset) {
+            return *reinterpret_cast<volatile std::uint32_t*>(baseAddress + offset);
+        }
+
+        [[gnu::always_inline]] static inline void barrier() {
+            asm volatile("dsb\n\t"
+                         "isb" ::
+                           : "memory");
+        }
+    }   // namespace Detail
+
+    // runtime indexed access for interrupts only known at runtime (DMA channel pools, pin
+    // interrupt multiplexers...), validated against the InterruptOffsetTraits tables which are
+    // folded into constexpr bitmaps so a check is one shift and AND
+    // only external interrupts (index >= 0) are supported, invalid indices are rejected
+    namespace Runtime {
+        static constexpr std::uint32_t enableMask
+          = Detail::validMask(InterruptOffsetTraits<void>::noEnable);
+        static constexpr std::uint32_t disableMask
+          = Detail::validMask(InterruptOffsetTraits<void>::noDisable);
+        static constexpr std::uint32_t setPendingMask
+          = Detail::validMask(InterruptOffsetTraits<void>::noSetPending);
+        static constexpr std::uint32_t clearPendingMask
+          = Detail::validMask(InterruptOffsetTraits<void>::noClearPending);
+        static constexpr std::uint32_t setPriorityMask
+          = Detail::validMask(InterruptOffsetTraits<void>::noSetPriority);
+
+        static constexpr bool isValid(std::uint32_t mask,
+                                      int           index) {
+            return unsigned(index) < 32U && ((mask >> unsigned(index)) & 1U) != 0;
+        }
+
+        [[nodiscard]] static inline bool enable(int index) {
+            if(!isValid(enableMask, index)) { return false; }
+            Detail::nvicWord(0x000) = 1U << unsigned(index);
+            return true;
+        }
+
+        // returns once the interrupt can no longer be taken
+        [[nodiscard]] static inline bool disable(int index) {
+            if(!isValid(disableMask, index)) { return false; }
+            Detail::nvicWord(0x080) = 1U << unsigned(index);
+            Detail::barrier();
+            return true;
+        }
+
+        [[nodiscard]] static inline bool setPending(int index) {
+            if(!isValid(setPendingMask, index)) { return false; }
+            Detail::nvicWord(0x100) = 1U << unsigned(index);
+            return true;
+        }
+
+        [[nodiscard]] static inline bool clearPending(int index) {
+            if(!isValid(clearPendingMask, index)) { return false; }
+            Detail::nvicWord(0x180) = 1U << unsigned(index);
+            return true;
+        }
+
+        // IPR only supports word access on ARMv6-M, so this is a masked read-modify-write
+        [[nodiscard]] static inline bool setPriority(int      index,
+                                                     unsigned priority) {
+            if(!isValid(setPriorityMask, index) || priority > 3) { return false; }
+            auto const            shift = (unsigned(index) % 4) * 8;
+            auto const            word  = 0x300 + (unsigned(index) / 4) * 4;
+            Core::CriticalSection cs;
+            auto const            old = Detail::nvicWord(word);
+            Detail::nvicWord(word)    = (old & ~(0xFFU << shift)) | ((priority << 6U) << shift);
+            return true;
+        }
+
+        static inline bool isEnabled(int index) {
+            return unsigned(index) < 32U
+                && ((Detail::nvicWord(0x000) >> unsigned(index)) & 1U) != 0;
+        }
+
+        static inline bool isPending(int index) {
+            return unsigned(index) < 32U
+                && ((Detail::nvicWord(0x100) >> unsigned(index)) & 1U) != 0;
+        }
+
+        // bulk operations on the whole ISER/ICER/ISPR/ICPR word, bits that are not allowed are
+        // dropped and the mask that was actually written is returned
+        static inline std::uint32_t enableAll(std::uint32_t mask) {
+            mask &= enableMask;
+            Detail::nvicWord(0x000) = mask;
+            return mask;
+        }
+
+        static inline std::uint32_t disableAll(std::uint32_t mask) {
+            mask &= disableMask;
+            Detail::nvicWord(0x080) = mask;
+            Detail::barrier();
+            return mask;
+        }
+
+        static inline std::uint32_t setPendingAll(std::uint32_t mask) {
+            mask &= setPendingMask;
+            Detail::nvicWord(0x100) = mask;
+            return mask;
+        }
+
+        static inline std::uint32_t clearPendingAll(std::uint32_t mask) {
+            mask &= clearPendingMask;
+            Detail::nvicWord(0x180) = mask;
+            return mask;
+        }
+
+        static inline std::uint32_t enabled() { return Detail::nvicWord(0x000); }
+
+        static inline std::uint32_t pending() { return Detail::nvicWord(0x100); }
+    }   // namespace Runtime
 }}   // namespace Kvasir::Nvic
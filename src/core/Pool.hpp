@@ -0,0 +1,116 @@
+#pragma once
+
+#include "CriticalSection.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace Kvasir::Core {
+
+// fixed block memory pool to hand buffers between ISRs and thread code without copying:
+//
+//   using RxPool = Kvasir::Core::BlockPool<128, 8>;
+//   // radio ISR
+//   if(void* b = RxPool::allocate()) { fill(b); (void)queue.post(&process, b); }
+//   // thread mode / PendSV
+//   void process(void* b) { ...; RxPool::release(b); }
+//
+// allocate() and release() are O(1) and callable from any priority, ARMv6-M has no LDREX/STREX
+// so both mask interrupts (PRIMASK) for the freelist update only, about 10 instructions
+// never handed out blocks are taken from a watermark so the pool needs no init and no init step,
+// a released block goes onto the freelist and its first word holds the link
+// Tag separates pools with the same geometry, they would share the blocks otherwise
+template<std::size_t BlockSize,
+         std::size_t Blocks,
+         typename Tag = void>
+struct BlockPool {
+    static constexpr std::size_t blockSize = (BlockSize + alignof(std::max_align_t) - 1)
+                                           & ~(alignof(std::max_align_t) - 1);
+    static constexpr std::size_t blocks    = Blocks;
+
+private:
+    static_assert(BlockSize != 0 && Blocks != 0, "empty pool");
+    static_assert(Blocks <= 0xFFFF, "block count to large for 16 bit counters");
+
+    struct Free {
+        Free* next;
+    };
+
+    alignas(std::max_align_t) static inline std::array<std::byte, blockSize * Blocks> memory{};
+
+    static inline Free*         freeList{};
+    static inline std::uint16_t watermark{};   // blocks never handed out start here
+    static inline std::uint16_t used{};
+    static inline std::uint16_t highWater{};
+
+public:
+    // nullptr if all blocks are in use
+    [[nodiscard]] static void* allocate() {
+        CriticalSection cs;
+        void*           block;
+        if(freeList != nullptr) {
+            block    = freeList;
+            freeList = freeList->next;
+        } else if(watermark != Blocks) {
+            block     = memory.data() + std::size_t(watermark) * blockSize;
+            watermark = std::uint16_t(watermark + 1U);
+        } else {
+            return nullptr;
+        }
+        used = std::uint16_t(used + 1U);
+        if(used > highWater) { highWater = used; }
+        return block;
+    }
+
+    // block has to come from allocate() of this pool, nullptr is ignored
+    static void release(void* block) {
+        if(block == nullptr) { return; }
+        CriticalSection cs;
+        freeList = ::new(block) Free{freeList};
+        used     = std::uint16_t(used - 1U);
+    }
+
+    // whether p points into a block of this pool, for checks at the ownership boundary
+    static bool owns(void const* p) {
+        auto const* const b = static_cast<std::byte const*>(p);
+        return b >= memory.data() && b < memory.data() + memory.size()
+            && std::size_t(b - memory.data()) % blockSize == 0;
+    }
+
+    template<typename T,
+             typename... Args>
+    [[nodiscard]] static T* create(Args&&... args) {
+        static_assert(sizeof(T) <= blockSize && alignof(T) <= alignof(std::max_align_t),
+                      "type does not fit into a block");
+        void* const block = allocate();
+        return block == nullptr ? nullptr : ::new(block) T(std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    static void destroy(T* p) {
+        if(p == nullptr) { return; }
+        p->~T();
+        release(p);
+    }
+
+    // for std::unique_ptr<T, BlockPool::Deleter>
+    struct Deleter {
+        template<typename T>
+        void operator()(T* p) const {
+            destroy(p);
+        }
+    };
+
+    static std::size_t available() {
+        CriticalSection cs;
+        return Blocks - used;
+    }
+
+    // most blocks in use at once since reset, to size Blocks
+    static std::size_t maxUsed() { return highWater; }
+};
+
+}   // namespace Kvasir::Core
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Kvasir::Systick {
+
+// sampling PC profiler, M0+ has neither ETM nor ITM so the Systick ISR samples the interrupted
+// PC from the exception frame, hook it up through the clock config:
+//
+//   using Profile = Kvasir::Systick::PcProfile<0x0000'0000, 0x0004'0000, 256>;
+//   struct ClockConfig { ... static void samplePc(std::uint32_t pc) { Profile::record(pc); } };
+//
+// the sample rate is the Systick rate, Config::samplePeriod sets it (2^24 ticks by default,
+// tickless clocks sample at least that often)
+//
+// the code range [CodeBegin, CodeEnd) is split into Buckets power of two sized buckets so
+// record() is a shift and an increment, PCs outside (RAM functions, bootloader) are only counted
+// interrupts running above Systick priority and code with interrupts masked are never sampled,
+// the latter shows up as a sample at the instruction unmasking them
+template<std::uint32_t CodeBegin,
+         std::uint32_t CodeEnd,
+         std::size_t   Buckets = 256>
+struct PcProfile {
+private:
+    static_assert(CodeEnd > CodeBegin, "empty code range");
+    static_assert(Buckets != 0 && (Buckets & (Buckets - 1)) == 0,
+                  "bucket count has to be a power of two");
+
+    static constexpr unsigned calcShift() {
+        unsigned shift = 1;   // Thumb instructions are at least 2 bytes
+        while((std::uint64_t(Buckets) << shift) < std::uint64_t(CodeEnd - CodeBegin)) { ++shift; }
+        return shift;
+    }
+
+    static inline std::array<std::uint32_t, Buckets> counts{};
+    static inline std::uint32_t                      outside{};
+
+public:
+    static constexpr unsigned      shift       = calcShift();
+    static constexpr std::uint32_t bucketBytes = std::uint32_t(1) << shift;
+
+    // called from the Systick ISR, nothing else writes the counts
+    static void record(std::uint32_t pc) {
+        std::uint32_t const bucket = (pc - CodeBegin) >> shift;
+        if(pc >= CodeBegin && bucket < Buckets) {
+            ++counts[bucket];
+        } else {
+            ++outside;
+        }
+    }
+
+    static void clear() {
+        counts.fill(0);
+        outside = 0;
+    }
+
+    // dump format read by tools/pc_profile.py, one line per call of line(text):
+    //   PCPROF begin=<hex> bucket=<bytes> outside=<n>
+    //   PCPROF <bucket start hex> <count>      (non empty buckets only)
+    // the counts may still change while dumping, they are sampled one by one
+    template<typename F>
+    static void dump(F&& line) {
+        std::array<char, 64> buffer{};
+        auto const           emit = [&](std::uint32_t a, std::uint32_t b, bool header) {
+            char*      p      = buffer.data();
+            auto const append = [&](char const* s) {
+                while(*s != '\0') { *p++ = *s++; }
+            };
+            auto const appendHex = [&](std::uint32_t v) {
+                append("0x");
+                for(int i = 28; i >= 0; i -= 4) { *p++ = "0123456789abcdef"[(v >> unsigned(i)) & 0xFU]; }
+            };
+            auto const appendDec = [&](std::uint32_t v) {
+                std::array<char, 10> digits{};
+                std::size_t          n = 0;
+                do {
+                    digits[n++] = char('0' + v % 10U);
+                    v /= 10U;
+                } while(v != 0);
+                while(n != 0) { *p++ = digits[--n]; }
+            };
+            append("PCPROF ");
+            if(header) {
+                append("begin=");
+                appendHex(a);
+                append(" bucket=");
+                appendDec(bucketBytes);
+                append(" outside=");
+                appendDec(b);
+            } else {
+                appendHex(a);
+                append(" ");
+                appendDec(b);
+            }
+            *p = '\0';
+            line(static_cast<char const*>(buffer.data()));
+        };
+
+        emit(CodeBegin, outside, true);
+        for(std::size_t i = 0; i < Buckets; ++i) {
+            if(counts[i] != 0) { emit(CodeBegin + std::uint32_t(i) * bucketBytes, counts[i], false); }
+        }
+    }
+};
+
+}   // namespace Kvasir::Systick
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Nvic.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+
+namespace Kvasir::Nvic {
+
+// the priority interrupt I is configured with
+template<int Priority,
+         typename I>
+struct PriorityOf;
+
+template<int Priority,
+         int I>
+struct PriorityOf<Priority, Index<I>> {
+    static_assert(Priority >= 0 && Priority <= 3,
+                  "priority on cortex_m0plus can only be 0-3 (2 bits implemented)");
+    static constexpr int index    = I;
+    static constexpr int priority = Priority;
+};
+
+// system wide interrupt priorities, the single source for configuring the NVIC and for
+// deriving the resource ceilings
+template<typename... Entries>
+struct PriorityTable {
+    static constexpr std::array<int, sizeof...(Entries)> indices{Entries::index...};
+    static constexpr std::array<int, sizeof...(Entries)> priorities{Entries::priority...};
+
+    static constexpr int priorityOf(int index) {
+        for(std::size_t i = 0; i < indices.size(); ++i) {
+            if(indices[i] == index) { return priorities[i]; }
+        }
+        return -1;
+    }
+
+    static constexpr auto initStepInterruptConfig
+      = list(MakeAction<Action::SetPriority<Entries::priority>, Index<Entries::index>>{}...);
+};
+
+// Stack Resource Policy style lock for data shared between the interrupts Users (and thread
+// mode), Cortex-M0+ has no BASEPRI so instead of PRIMASK the lock disables in ICER exactly the
+// external interrupts of the table whose priority is at or below the ceiling (the most urgent
+// user), more urgent interrupts keep running with unchanged latency
+//
+// lock costs an ISER load, an ICER store and DSB/ISB, unlock a single ISER store
+// interrupts pending while locked stay pending and are taken on unlock
+// interrupts in the mask must not be enabled or disabled by more urgent ISRs while locked
+template<typename Table,
+         typename... Users>
+struct Resource {
+private:
+    static constexpr int calcCeiling() {
+        int ceiling = 4;
+        for(int const user : {Users{}.index()...}) {
+            ceiling = std::min(ceiling, Table::priorityOf(user));
+        }
+        return ceiling;
+    }
+
+    static constexpr std::uint32_t calcMask() {
+        std::uint32_t mask{};
+        for(std::size_t i = 0; i < Table::indices.size(); ++i) {
+            if(Table::indices[i] >= 0 && Table::priorities[i] >= ceiling) {
+                mask |= 1U << unsigned(Table::indices[i]);
+            }
+        }
+        return mask;
+    }
+
+    static_assert(sizeof...(Users) != 0, "a resource needs at least one user");
+    static_assert(((Table::priorityOf(Users{}.index()) >= 0) && ...),
+                  "every user has to be in the priority table");
+    static_assert(((Users{}.index() >= 0) && ...),
+                  "core exceptions can not be masked through the NVIC, use "
+                  "Core::CriticalSection for resources shared with them");
+
+public:
+    static constexpr int           ceiling = calcCeiling();
+    static constexpr std::uint32_t mask    = calcMask();
+
+    struct Lock {
+        [[gnu::always_inline]] Lock() : enabled{Detail::nvicWord(0x000) & mask} {
+            Detail::nvicWord(0x080) = mask;
+            Detail::barrier();
+        }
+
+        [[gnu::always_inline]] ~Lock() { Detail::nvicWord(0x000) = enabled; }
+
+        Lock(Lock const&)            = delete;
+        Lock& operator=(Lock const&) = delete;
+
+    private:
+        std::uint32_t enabled;
+    };
+
+    template<typename F>
+    static decltype(auto) access(F&& f) {
+        Lock lock{};
+        return f();
+    }
+};
+
+}   // namespace Kvasir::Nvic
@@ -0,0 +1,10 @@
+#pragma once
+
+// objects that keep their content over a reset, the linker script has to place .noinit outside
+// of .bss (NOLOAD) so neither the startup code nor the C runtime touches it
+#define KVASIR_NO_INIT [[gnu::section(".noinit")]]
+
+// zero initialized objects that are only zeroed when Startup::Core::zeroLazy() is called, for
+// large buffers not needed right after reset, the linker script has to place .lazy_bss (NOLOAD)
+// between __lazy_bss_start__ and __lazy_bss_end__
+#define KVASIR_LAZY_ZERO [[gnu::section(".lazy_bss")]]
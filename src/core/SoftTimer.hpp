@@ -0,0 +1,252 @@
+#pragma once
+
+#include "CriticalSection.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+
+namespace Kvasir::Systick {
+
+// storage for one software timer, owned by the user (usually static) and linked into the wheel
+// of a TimerService while active
+struct Timer {
+    using Callback = void (*)(Timer&);
+
+    constexpr explicit Timer(Callback cb) : callback{cb} {}
+
+    Timer(Timer const&)            = delete;
+    Timer& operator=(Timer const&) = delete;
+
+private:
+    template<typename, unsigned, unsigned>
+    friend struct TimerService;
+
+    Callback      callback;
+    std::uint32_t period{};   // wheel ticks, 0 for one-shot
+    std::uint32_t expiry{};   // absolute wheel tick
+    Timer*        next{};
+    Timer*        prev{};
+    std::uint8_t  level{};
+    std::uint8_t  slot{};
+    bool          active{};
+};
+
+// one-shot and periodic software timers on a hierarchical timer wheel driven by the Systick ISR
+// Clock has to be a tickless SystickClockBase whose Config::onTick() calls process()
+//
+// one wheel tick is 2^ResolutionShift clock ticks, every level has 32 slots so Levels levels
+// cover 2^(5 * Levels) wheel ticks, longer timers are parked in the last slot and re-cascaded
+// start and cancel are O(1) and mask interrupts for a few dozen instructions, process() skips
+// empty slots using one occupancy bitmap per level and runs callbacks with interrupts enabled
+template<typename Clock,
+         unsigned ResolutionShift = 8,
+         unsigned Levels          = 4>
+struct TimerService {
+private:
+    static constexpr unsigned      SlotBits = 5;
+    static constexpr unsigned      Slots    = 1U << SlotBits;
+    static constexpr std::uint32_t SlotMask = Slots - 1U;
+    static constexpr std::uint32_t MaxDelta = (std::uint32_t(1) << (SlotBits * Levels)) - 1U;
+
+    static_assert(Levels >= 1 && SlotBits * Levels < 32, "wheel range has to fit 32 bits");
+
+    using duration   = typename Clock::duration;
+    using time_point = typename Clock::time_point;
+    using rep        = typename Clock::rep;
+
+    static inline std::array<std::array<Timer*, Slots>, Levels> wheel{};
+    static inline std::array<std::uint32_t, Levels>             occupied{};
+    static inline std::uint32_t                                 current{};
+
+    static constexpr std::uint64_t round   = (std::uint64_t(1) << ResolutionShift) - 1U;
+    static constexpr std::uint64_t longest = (std::uint64_t(1) << 31U) - 1U;
+
+    // expiries are compared modulo 2^32, so periods are limited to 2^31 wheel ticks
+    static std::uint32_t toWheelTicks(duration d) {
+        auto const ticks = (std::uint64_t(d.count()) + round) >> ResolutionShift;
+        return ticks > longest ? std::uint32_t(longest) : std::uint32_t(ticks);
+    }
+
+    // first wheel tick at or after nowTicks + d, a wheel tick fires once the clock reaches its
+    // start so the timer never fires early, rounding now down and d up separately would make
+    // it up to one wheel tick early, a delay of 0 or less (a deadline already passed) fires on
+    // the next wheel tick, delays are limited to 2^31 wheel ticks
+    static std::uint32_t expiryAfter(std::uint64_t nowTicks,
+                                     duration      d) {
+        std::uint64_t const nowWheel = nowTicks >> ResolutionShift;
+        std::uint64_t const delay
+          = d.count() <= 0 ? 0U : std::min(std::uint64_t(d.count()), longest << ResolutionShift);
+        std::uint64_t const at = (nowTicks + delay + round) >> ResolutionShift;
+        return std::uint32_t(at > nowWheel ? at : nowWheel + 1U);
+    }
+
+    static std::uint32_t wheelNow() {
+        return std::uint32_t(std::uint64_t(Clock::now().time_since_epoch().count())
+                             >> ResolutionShift);
+    }
+
+    static bool empty() {
+        for(auto const o : occupied) {
+            if(o != 0) { return false; }
+        }
+        return true;
+    }
+
+    // interrupts masked for all of the below
+    static void link(Timer& t) {
+        std::uint32_t const delta = t.expiry - current;
+        unsigned            level = 0;
+        while(level + 1 < Levels && delta >= (std::uint32_t(1) << (SlotBits * (level + 1)))) {
+            ++level;
+        }
+        std::uint32_t const parked = delta > MaxDelta ? current + MaxDelta : t.expiry;
+        auto const          slot   = (parked >> (SlotBits * level)) & SlotMask;
+
+        Timer*& head = wheel[level][slot];
+        t.level      = std::uint8_t(level);
+        t.slot       = std::uint8_t(slot);
+        t.prev       = nullptr;
+        t.next       = head;
+        if(head != nullptr) { head->prev = &t; }
+        head = &t;
+        occupied[level] |= 1U << slot;
+        t.active = true;
+    }
+
+    static void unlink(Timer& t) {
+        Timer*& head = wheel[t.level][t.slot];
+        if(t.prev != nullptr) {
+            t.prev->next = t.next;
+        } else {
+            head = t.next;
+        }
+        if(t.next != nullptr) { t.next->prev = t.prev; }
+        if(head == nullptr) { occupied[t.level] &= ~(1U << t.slot); }
+        t.active = false;
+    }
+
+    // wheel tick of the next slot that expires or cascades, at most current + 2^(5 * Levels)
+    static std::uint32_t nextEvent() {
+        std::uint32_t best = MaxDelta + 1U;
+        for(unsigned level = 0; level < Levels; ++level) {
+            std::uint32_t const bits = occupied[level];
+            if(bits == 0) { continue; }
+            std::uint32_t const shifted = current >> (SlotBits * level);
+            int const           rot     = int((shifted + 1U) & SlotMask);
+            auto const          steps   = std::uint32_t(std::countr_zero(std::rotr(bits, rot))) + 1U;
+            std::uint32_t const at      = (shifted + steps) << (SlotBits * level);
+            if(at - current < best) { best = at - current; }
+        }
+        return current + best;
+    }
+
+    static void cascade(unsigned level) {
+        auto const slot = (current >> (SlotBits * level)) & SlotMask;
+        while(true) {
+            Core::CriticalSection cs;
+            Timer* const          t = wheel[level][slot];
+            if(t == nullptr) { break; }
+            unlink(*t);
+            link(*t);
+        }
+    }
+
+    static void expire() {
+        auto const slot = current & SlotMask;
+        while(true) {
+            Timer* t;
+            {
+                Core::CriticalSection cs;
+                t = wheel[0][slot];
+                if(t == nullptr) { break; }
+                unlink(*t);
+                if(t->period != 0) {
+                    t->expiry += t->period;
+                    link(*t);
+                }
+            }
+            t->callback(*t);
+        }
+    }
+
+    static void advance(std::uint32_t target) {
+        while(true) {
+            {
+                Core::CriticalSection cs;
+                std::uint32_t const next = nextEvent();
+                if(next - current > target - current) {
+                    current = target;
+                    return;
+                }
+                current = next;
+            }
+            for(unsigned level = Levels - 1; level > 0; --level) {
+                if((current & ((std::uint32_t(1) << (SlotBits * level)) - 1U)) == 0) {
+                    cascade(level);
+                }
+            }
+            expire();
+        }
+    }
+
+    static void schedule() {
+        std::uint32_t next;
+        {
+            Core::CriticalSection cs;
+            if(empty()) { return; }
+            next = nextEvent();
+        }
+        // current may lag behind now when called outside the ISR, an overdue slot fires at once
+        auto const nowTicks = std::uint64_t(Clock::now().time_since_epoch().count());
+        auto const nowWheel = nowTicks >> ResolutionShift;
+        auto const ahead    = std::int32_t(next - std::uint32_t(nowWheel));
+        auto const at = ahead <= 0 ? nowTicks : (nowWheel + std::uint64_t(ahead)) << ResolutionShift;
+        Clock::requestDeadline(time_point{duration{rep(at)}});
+    }
+
+public:
+    // (re)starts t to fire after delay and then every period, a zero period makes it one-shot
+    // the first expiry is never early, the period is rounded up to whole wheel ticks
+    // callable from any context, the callback runs in the Systick ISR
+    static void start(Timer&   t,
+                      duration delay,
+                      duration period = duration::zero()) {
+        {
+            Core::CriticalSection cs;
+            auto const nowTicks = std::uint64_t(Clock::now().time_since_epoch().count());
+            if(t.active) { unlink(t); }
+            if(empty()) { current = std::uint32_t(nowTicks >> ResolutionShift); }
+            t.period = period > duration::zero() ? toWheelTicks(period) : 0;
+            t.expiry = expiryAfter(nowTicks, delay);
+            link(t);
+        }
+        schedule();
+    }
+
+    template<typename Rep,
+             typename Period>
+    static void start(Timer&                             t,
+                      std::chrono::duration<Rep, Period> delay,
+                      std::chrono::duration<Rep, Period> period
+                      = std::chrono::duration<Rep, Period>::zero()) {
+        start(t, Clock::fromDuration(delay), Clock::fromDuration(period));
+    }
+
+    static void cancel(Timer& t) {
+        Core::CriticalSection cs;
+        if(t.active) { unlink(t); }
+    }
+
+    static bool isActive(Timer const& t) { return t.active; }
+
+    // call from Config::onTick() of the clock
+    static void process() {
+        advance(wheelNow());
+        schedule();
+    }
+};
+
+}   // namespace Kvasir::Systick
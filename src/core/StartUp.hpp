@@ -1,7 +1,97 @@
 #pragma once
 
+#include "Sections.hpp"
+#include "core_peripherals/SYSTICK.hpp"
+#include "kvasir/Register/Register.hpp"
+
+#include <cstdint>
+
+// keeps GCC (-O2 and up) and Clang from turning the copy and zero loops into memcpy/memset
+// calls, which would run before the C library is set up, has to be on the loops and on every
+// function they are inlined into
+#if defined(__clang__)
+#    define KVASIR_STARTUP_NO_LIBCALLS [[clang::no_builtin("memcpy", "memset")]]
+#else
+#    define KVASIR_STARTUP_NO_LIBCALLS [[gnu::optimize("no-tree-loop-distribute-patterns")]]
+#endif
+
+// section bounds from the linker script, all have to be word aligned, a linker script without
+// them fails to link instead of silently skipping the initialization, an unused section has
+// equal bounds
+extern "C" {
+extern std::uint32_t __data_load__[];
+extern std::uint32_t __data_start__[];
+extern std::uint32_t __data_end__[];
+extern std::uint32_t __bss_start__[];
+extern std::uint32_t __bss_end__[];
+extern std::uint32_t __lazy_bss_start__[];
+extern std::uint32_t __lazy_bss_end__[];
+}
+
 namespace Kvasir::Startup::Core {
 
-static void startup() {}
+namespace Detail {
+    using SystickRegs = Kvasir::Peripheral::SYSTICK::Registers<>;
+
+    static constexpr std::uint32_t measureReload = 0x00FF'FFFF;
+
+    // four words per iteration, runs before .data/.bss exist so only locals are used
+    KVASIR_STARTUP_NO_LIBCALLS [[gnu::always_inline]] static inline void
+      copyWords(std::uint32_t*       dst,
+                std::uint32_t*       end,
+                std::uint32_t const* src) {
+        while(end - dst >= 4) {
+            std::uint32_t const a = src[0];
+            std::uint32_t const b = src[1];
+            std::uint32_t const c = src[2];
+            std::uint32_t const d = src[3];
+            dst[0]                = a;
+            dst[1]                = b;
+            dst[2]                = c;
+            dst[3]                = d;
+            dst += 4;
+            src += 4;
+        }
+        while(dst != end) { *dst++ = *src++; }
+    }
+
+    KVASIR_STARTUP_NO_LIBCALLS [[gnu::always_inline]] static inline void
+      zeroWords(std::uint32_t* dst,
+                std::uint32_t* end) {
+        while(end - dst >= 4) {
+            dst[0] = 0;
+            dst[1] = 0;
+            dst[2] = 0;
+            dst[3] = 0;
+            dst += 4;
+        }
+        while(dst != end) { *dst++ = 0; }
+    }
+}   // namespace Detail
+
+// first step after reset, replaces the .data/.bss loops of the C runtime
+// also starts Systick free running on the processor clock so ticksSinceReset() can measure the
+// time to main, Systick is reconfigured later by the clock init steps
+KVASIR_STARTUP_NO_LIBCALLS static inline void startup() {
+    apply(write(Detail::SystickRegs::RVR::reload, Register::value<Detail::measureReload>()),
+          write(Detail::SystickRegs::CVR::current, Register::value<0>()),
+          write(Detail::SystickRegs::CSR::CLKSOURCEValC::processor),
+          write(Detail::SystickRegs::CSR::ENABLEValC::counter_is_operating));
+
+    std::uint32_t const* const load = __data_load__;
+    if(load != __data_start__) { Detail::copyWords(__data_start__, __data_end__, load); }
+    Detail::zeroWords(__bss_start__, __bss_end__);
+}
+
+// zeroes the KVASIR_LAZY_ZERO objects, has to be called before the first of them is used
+KVASIR_STARTUP_NO_LIBCALLS static inline void zeroLazy() {
+    Detail::zeroWords(__lazy_bss_start__, __lazy_bss_end__);
+}
+
+// processor clock cycles since startup() began, call first thing in main for the reset to main
+// time, only valid until Systick is reconfigured and for up to 2^24 cycles
+static inline std::uint32_t ticksSinceReset() {
+    return Detail::measureReload - std::uint32_t(apply(read(Detail::SystickRegs::CVR::current)));
+}
 
 }   // namespace Kvasir::Startup::Core
@@ -13,6 +13,95 @@ namespace SystemControl {
     using SystemReset = decltype(Kvasir::Peripheral::SCB::Registers<>::AIRCR::overrideDefaults(
       write(Kvasir::Peripheral::SCB::Registers<>::AIRCR::VECTKEYValC::request_reset),
       write(Kvasir::Peripheral::SCB::Registers<>::AIRCR::SYSRESETREQValC::request_reset)));
+
+    // sleeps until an interrupt is pending, also wakes if PRIMASK is set so a check-then-sleep
+    // sequence can be done race free inside a Core::CriticalSection
+#if defined(__ARM_ARCH)
+    [[gnu::always_inline]] static inline void waitForInterrupt() { asm volatile("wfi" ::: "memory"); }
+
+    // sleeps until an event, with wakeOnPending also the pending of a disabled interrupt
+    // the event register may already be set, so wait in a loop on the actual condition
+    [[gnu::always_inline]] static inline void waitForEvent() { asm volatile("wfe" ::: "memory"); }
+
+    [[gnu::always_inline]] static inline void dataBarrier() { asm volatile("dsb" ::: "memory"); }
+#else
+    namespace HostDetail {
+        inline void (*onWait)(){};
+    }   // namespace HostDetail
+
+    // host builds let the simulation advance to the next interrupt
+    static inline void waitForInterrupt() {
+        if(HostDetail::onWait != nullptr) { HostDetail::onWait(); }
+    }
+
+    static inline void waitForEvent() { waitForInterrupt(); }
+
+    static inline void dataBarrier() {}
+#endif
+
+    namespace detail { using SCR = Kvasir::Peripheral::SCB::Registers<>::SCR; }
+
+    enum class SleepMode { sleep, deepSleep };
+
+    // SCR.SLEEPDEEP, what the next WFI/WFE or sleep-on-exit enters, deep sleep is vendor
+    // specific (clocks stopped, longer wakeup)
+    template<SleepMode Mode>
+    static constexpr auto selectSleepMode = [] {
+        if constexpr(Mode == SleepMode::deepSleep) {
+            return write(detail::SCR::SLEEPDEEPValC::selected_sleep_state_is_deep_sleep);
+        } else {
+            return write(detail::SCR::SLEEPDEEPValC::selected_sleep_state_is_not_deep_sleep);
+        }
+    }();
+
+    // SCR.SLEEPONEXIT, returning from the last active ISR to thread mode sleeps again right away
+    // without unstacking, the next interrupt is taken without stacking, so a firmware that does
+    // everything in ISRs saves the thread mode round trip on every interrupt
+    static constexpr auto sleepOnExit
+      = write(detail::SCR::SLEEPONEXITValC::enter_sleep_state);
+    static constexpr auto noSleepOnExit
+      = write(detail::SCR::SLEEPONEXITValC::do_not_enter_sleep_state);
+
+    // SCR.SEVONPEND, an interrupt becoming pending is a wakeup event for WFE even when it is
+    // disabled in the NVIC or masked, so a thread can sleep on a peripheral without running an ISR
+    static constexpr auto wakeOnPending
+      = write(detail::SCR::SEVONPENDValC::transitions_from_inactive_to_pending_are_wakeup_events);
+    static constexpr auto noWakeOnPending = write(
+      detail::SCR::SEVONPENDValC::transitions_from_inactive_to_pending_are_not_wakeup_events);
+
+    // sleeps once in Mode until an interrupt is pending
+    template<SleepMode Mode = SleepMode::sleep>
+    static void sleep() {
+        apply(selectSleepMode<Mode>, noSleepOnExit);
+        dataBarrier();
+        waitForInterrupt();
+    }
+
+    // hands the core to the interrupts for good, thread mode only continues after an ISR called
+    // leaveInterruptDrivenMode(), all setup has to be done before
+    template<SleepMode Mode = SleepMode::sleep>
+    static void enterInterruptDrivenMode() {
+        apply(selectSleepMode<Mode>, sleepOnExit);
+        dataBarrier();
+        waitForInterrupt();
+    }
+
+    // from an ISR, the return from it goes back to thread mode instead of to sleep
+    static inline void leaveInterruptDrivenMode() { apply(noSleepOnExit); }
+
+    // one WFE in Mode, wakes when an interrupt becomes pending (SEVONPEND), enabled or not, but
+    // returns right away if the event register is already set (an earlier event or SEV), so
+    // callers loop on their condition:
+    //
+    //   while(!uartHasData()) { SystemControl::sleepUntilPending(); }
+    //
+    // the pending bit has to be cleared by the caller if the interrupt stays disabled
+    template<SleepMode Mode = SleepMode::sleep>
+    static void sleepUntilPending() {
+        apply(selectSleepMode<Mode>, noSleepOnExit, wakeOnPending);
+        dataBarrier();
+        waitForEvent();
+    }
 }
 
 namespace Nvic {
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "CriticalSection.hpp"
 #include "SystemControl.hpp"
+#include "TickConversion.hpp"
 #include "core_peripherals/SCB.hpp"
 #include "core_peripherals/SYSTICK.hpp"
 #include "kvasir/Atomic/Atomic.hpp"
@@ -8,14 +10,85 @@
 #include "kvasir/Register/Register.hpp"
 #include "kvasir/Register/Utility.hpp"
 
-#include <atomic>
+#include <algorithm>
 #include <chrono>
+#include <limits>
 
 namespace Kvasir {
 namespace Systick {
     using SystickRegs                       = Kvasir::Peripheral::SYSTICK::Registers<>;
     static constexpr auto useExternalClock  = SystickRegs::CSR::CLKSOURCEValC::external;
     static constexpr auto useProcessorClock = SystickRegs::CSR::CLKSOURCEValC::processor;
+
+    namespace Detail {
+        template<typename Config>
+        constexpr bool isTickless() {
+            if constexpr(requires { Config::tickless; }) {
+                return Config::tickless;
+            } else {
+                return false;
+            }
+        }
+
+        template<typename Config>
+        constexpr std::uint32_t reprogramTicks() {
+            if constexpr(requires { Config::reprogramTicks; }) {
+                return Config::reprogramTicks;
+            } else {
+                return 0;
+            }
+        }
+
+        template<typename Config>
+        constexpr std::uint32_t wakeupTicks() {
+            if constexpr(requires { Config::wakeupTicks; }) {
+                return Config::wakeupTicks;
+            } else {
+                return 64;
+            }
+        }
+
+        template<typename Config>
+        constexpr std::uint32_t samplePeriod() {
+            if constexpr(requires { Config::samplePeriod; }) {
+                return Config::samplePeriod;
+            } else {
+                return 1U << 24U;
+            }
+        }
+
+        // register access of SystickClockBase, Config::hardware replaces it (see HostSystick.hpp)
+        struct Registers {
+            static std::uint32_t currentCount() { return apply(read(SystickRegs::CVR::current)); }
+
+            static bool wrapPending() {
+                using ScbRegs = Kvasir::Peripheral::SCB::Registers<>;
+                return fieldEquals(ScbRegs::ICSR::PENDSTSETValC::set_pending);
+            }
+
+            static void setReload(std::uint32_t reload) {
+                apply(write(SystickRegs::RVR::reload, reload));
+            }
+
+            static void clearCount() { apply(write(SystickRegs::CVR::current, Register::value<0>())); }
+        };
+
+        template<typename Config>
+        struct HardwareOf {
+            using type = Registers;
+        };
+
+        template<typename Config>
+            requires requires { typename Config::hardware; }
+        struct HardwareOf<Config> {
+            using type = typename Config::hardware;
+        };
+
+        template<typename Config>
+        constexpr bool isSampling() {
+            return requires(std::uint32_t pc) { Config::samplePc(pc); };
+        }
+    }   // namespace Detail
 }   // namespace Systick
 
 namespace Nvic {
@@ -64,8 +137,19 @@ namespace Systick {
         // clockSpeed
         // clockBase
         // minOverrunTime
+        // optional config
+        // tickless        reprogram the reload to the next deadline instead of a fixed period
+        // reprogramTicks  ticks between reading and clearing CVR when restarting a period
+        // wakeupTicks     ticks a runtime delay wakes early to spin out the rest, covers the
+        //                 Systick ISR and the return from WFI
+        // onTick()        called from the Systick ISR after the time base is updated
+        // samplePc(pc)    called from the Systick ISR with the interrupted PC, see PcProfile
+        // samplePeriod    longest Systick period in ticks (default 2^24), the sample rate of
+        //                 samplePc(), fixed period: the period, tickless: caps each reload
+        // hardware        replaces the register access, see Detail::Registers
         using Config                              = TConfig;
         static constexpr std::uint64_t ClockSpeed = Config::clockSpeed;
+        static constexpr bool          Tickless   = Detail::isTickless<Config>();
         using Regs                                = Kvasir::Peripheral::SYSTICK::Registers<>;
 
     public:
@@ -78,6 +162,7 @@ namespace Systick {
         using time_point = std::chrono::time_point<SystickClockBase, duration>;
 
         static constexpr bool is_steady = true;
+        static constexpr bool tickless  = Tickless;
 
         template<typename Rep,
                  typename Period>
@@ -125,7 +210,7 @@ namespace Systick {
 
         static constexpr std::uint32_t calcReloadValue(std::uint64_t clockSpeed) {
             (void)clockSpeed;
-            return (1U << 24U) - 1U;
+            return Detail::samplePeriod<Config>() - 1U;
         }
 
         static constexpr std::uint64_t calcOverRunValue(std::uint64_t            clockSpeed,
@@ -138,49 +223,251 @@ namespace Systick {
         }
 
         using overrunT = GetOverrunTypeT<calcOverRunValue(ClockSpeed, Config::minOverrunTime)>;
-        static inline std::atomic<overrunT> overruns{};
+        // only written by the ISR and read with interrupts masked, so no atomic is needed and a
+        // 64 bit overrunT never ends up in libatomic on ARMv6-M
+        static inline overrunT overruns{};
 
-        static void onIsr() {
-            overrunT old = overruns.load(std::memory_order_relaxed);
-            ++old;
-            overruns.store(old, std::memory_order_relaxed);
+        using Hardware = typename Detail::HardwareOf<Config>::type;
+
+        static std::uint32_t currentCount() { return Hardware::currentCount(); }
+
+        static bool wrapPending() { return Hardware::wrapPending(); }
+
+        static constexpr std::uint32_t maxReload = calcReloadValue(ClockSpeed);
+
+        // tickless state, only touched with interrupts masked
+        // the counter value c in the running period corresponds to periodBase + periodReload - c
+        static constexpr std::uint32_t minReload  = 256;
+        static constexpr std::uint64_t noDeadline = std::numeric_limits<std::uint64_t>::max();
+
+        static_assert(Detail::samplePeriod<Config>() > minReload
+                        && Detail::samplePeriod<Config>() <= (1U << 24U),
+                      "samplePeriod has to be within 257 and 2^24 ticks");
+
+        static inline std::uint64_t periodBase{};
+        static inline std::uint32_t periodReload{maxReload};
+        static inline std::uint32_t nextReload{maxReload};
+        static inline std::uint64_t deadline{noDeadline};
+
+        struct Snapshot {
+            std::uint64_t ticks;
+            bool          wrapPending;
+        };
+
+        // one consistent reading of the tickless time base, interrupts must be masked
+        // a wrap that happened after masking is visible as a pending Systick and is accounted for
+        // without touching the state, the count 0 still belongs to the period that is ending
+        static Snapshot ticklessSnapshot() {
+            std::uint32_t const count = currentCount();
+            if(!wrapPending()) { return {periodBase + (periodReload - count), false}; }
+            std::uint32_t const countAfter = currentCount();
+            std::uint64_t const fire       = periodBase + periodReload;
+            return {countAfter == 0 ? fire : fire + (nextReload + 1U - countAfter), true};
         }
 
-        static void delay_ticks(std::uint32_t ticksToWait) {
-            std::uint32_t const countStart    = apply(read(Regs::CVR::current));
-            overrunT const      overrunsStart = overruns.load(std::memory_order_relaxed);
-            while(true) {
-                std::uint32_t const countNow    = apply(read(Regs::CVR::current));
-                overrunT const      overrunsNow = overruns.load(std::memory_order_relaxed);
-                auto const          countsRaw   = std::int32_t(countStart - countNow);
-                std::uint32_t const countsElapsed
-                  = countsRaw >= 0 ? std::uint32_t(countsRaw)
-                                   : countStart + (calcReloadValue(ClockSpeed) - countNow);
-                if(countsElapsed >= ticksToWait || overrunsNow - overrunsStart >= 2
-                   || (countNow < countStart && overrunsNow - overrunsStart == 1))
-                {
-                    break;
+        // same as ticklessSnapshot for the fixed period, computed in T so the 32 bit timestamp
+        // path stays free of 64 bit arithmetic
+        template<typename T>
+        [[clang::no_sanitize("unsigned-integer-overflow")]] static T periodicTicks() {
+            constexpr T         period     = T(maxReload) + 1U;
+            std::uint32_t const count      = currentCount();
+            T const             base       = T(overruns) * period;
+            if(!wrapPending()) { return base + (maxReload - count); }
+            std::uint32_t const countAfter = currentCount();
+            return countAfter == 0 ? base + maxReload : base + period + (maxReload - countAfter);
+        }
+
+        template<typename T>
+        static T ticks() {
+            if constexpr(Tickless) {
+                return T(ticklessSnapshot().ticks);
+            } else {
+                return periodicTicks<T>();
+            }
+        }
+
+        static std::uint32_t reloadFor(std::uint64_t ticks) {
+            return std::uint32_t(
+              std::clamp<std::uint64_t>(ticks, minReload, std::uint64_t(maxReload)));
+        }
+
+        // ticks from the CVR read of the snapshot to the CVR clear of a restart plus the tick the
+        // cleared counter needs to reload
+        static constexpr std::uint64_t restartTicks
+          = std::uint64_t(Detail::reprogramTicks<Config>()) + 1U;
+        // count an RVR only write has to be ahead of 0 so it lands before the reload, the write
+        // follows the snapshot as closely as the CVR clear of a restart
+        static constexpr std::uint64_t reloadMargin = restartTicks + 16U;
+
+        // programs the counter so the next interrupt fires at deadline, interrupts must be masked
+        // the running period is only cut short when the deadline lies before its end, with the
+        // count at least minReload away from 0, otherwise only RVR is written which takes effect
+        // exactly at the next reload, with the count at least reloadMargin away from 0
+        // so the counter can not reload between the snapshot and the store, closer to 0 the ISR
+        // is about to run and reprograms then
+        static void reprogram() {
+            Snapshot const snapshot = ticklessSnapshot();
+            // the ISR runs as soon as interrupts are unmasked and reprograms then
+            if(snapshot.wrapPending) { return; }
+
+            std::uint64_t const fire = periodBase + periodReload;
+            if(deadline < fire) {
+                if(snapshot.ticks + restartTicks + minReload < fire) {
+                    std::uint64_t const wanted
+                      = deadline > snapshot.ticks + restartTicks
+                        ? deadline - (snapshot.ticks + restartTicks)
+                        : 0;
+                    std::uint32_t const reload = reloadFor(wanted);
+                    Hardware::setReload(reload);
+                    Hardware::clearCount();
+                    bool const stalled = wrapPending();
+                    if(stalled) {
+                        // only a stall of more than minReload ticks (NMI) gets here, the old
+                        // period ended before the clear, the ISR takes the clear for its reload
+                        nextReload = reload;
+                    } else {
+                        periodBase   = snapshot.ticks + restartTicks;
+                        periodReload = reload;
+                        nextReload   = reload;
+                    }
+                    // the cleared count reads 0 until the next tick reloads it, a 0 would
+                    // otherwise be taken for the end of the new period
+                    while(currentCount() == 0) {}
+                    if(!stalled) {
+                        // the deadline is within the new period, after it the longest period
+                        // follows so a late ISR (masked interrupts) does not miss short wraps
+                        Hardware::setReload(maxReload);
+                        nextReload = maxReload;
+                    }
+                    return;
                 }
             }
+
+            // a period shortened to minReload reaches its ISR with less than minReload left, the
+            // margin has to be smaller so the ISR can put the longest reload back
+            if(fire - snapshot.ticks <= reloadMargin) { return; }
+            std::uint32_t const reload
+              = deadline == noDeadline || deadline <= fire + 1U ? maxReload
+                                                                : reloadFor(deadline - (fire + 1U));
+            if(reload != nextReload) {
+                Hardware::setReload(reload);
+                nextReload = reload;
+            }
+        }
+
+        static void onIsr() {
+            if constexpr(Tickless) {
+                Core::CriticalSection cs;
+                periodBase   = periodBase + periodReload + 1U;
+                periodReload = nextReload;
+                if(deadline <= periodBase) { deadline = noDeadline; }
+                reprogram();
+            } else {
+                // Systick runs at the highest priority, readers mask interrupts
+                overruns = overruns + 1U;
+            }
+            if constexpr(requires { Config::onTick(); }) { Config::onTick(); }
+        }
+
+        static void onSampledIsr(std::uint32_t const* frame) {
+            Config::samplePc(frame[6]);
+            onIsr();
+        }
+
+        // finds the exception frame on the stack EXC_RETURN bit 2 selects and tail calls
+        // onSampledIsr with it, lr still holds EXC_RETURN so that returns from the exception
+        [[gnu::naked]] static void sampledIsr() {
+            asm volatile("movs r0, #4\n\t"
+                         "mov r1, lr\n\t"
+                         "tst r0, r1\n\t"
+                         "beq 1f\n\t"
+                         "mrs r0, psp\n\t"
+                         "b 2f\n\t"
+                         "1:\n\t"
+                         "mrs r0, msp\n\t"
+                         "2:\n\t"
+                         "ldr r1, 3f\n\t"
+                         "bx r1\n\t"
+                         ".align 2\n\t"
+                         "3:\n\t"
+                         ".word %c0\n\t" ::"i"(&onSampledIsr));
+        }
+
+        static constexpr auto isrHandler = [] {
+            if constexpr(Detail::isSampling<Config>()) {
+                return &sampledIsr;
+            } else {
+                return &onIsr;
+            }
+        }();
+
+        static void delay_ticks(std::uint32_t ticksToWait) {
+            auto const start = now32();
+            while(std::uint32_t((now32() - start).count()) < ticksToWait) {}
         }
 
     public:
-        [[clang::no_sanitize("unsigned-integer-overflow")]] static time_point now() {
-            static constexpr auto reloadValue = calcReloadValue(ClockSpeed);
+        // wrapping 32 bit tick count for measuring intervals shorter than 2^31 ticks
+        struct Timestamp32 {
+            std::uint32_t ticks;
+
+            [[clang::no_sanitize("unsigned-integer-overflow")]] friend constexpr duration
+            operator-(Timestamp32 lhs,
+                      Timestamp32 rhs) {
+                return duration{std::int32_t(lhs.ticks - rhs.ticks)};
+            }
+
+            friend constexpr bool operator==(Timestamp32 lhs,
+                                             Timestamp32 rhs)
+              = default;
+        };
 
-            std::uint32_t currentCount{};
-            overrunT      localOverruns;
+        // division free tick <-> duration conversion traits, see Detail::ReciprocalConversion
+        // for the error bounds, e.g. ToConversion<std::chrono::microseconds>::exact
+        template<typename ToDuration>
+        using ToConversion
+          = Detail::ReciprocalConversion<std::ratio_divide<typename duration::period,
+                                                           typename ToDuration::period>>;
+
+        template<typename FromDuration>
+        using FromConversion
+          = Detail::ReciprocalConversion<std::ratio_divide<typename FromDuration::period,
+                                                           typename duration::period>>;
+
+        // same as duration_cast for exact conversions, otherwise at most
+        // ToConversion<ToDuration>::maxError to large, only values outside 0..2^32-1 ticks take
+        // the dividing duration_cast path
+        template<typename ToDuration>
+        static constexpr ToDuration toDuration(duration d) {
+            auto const ticks = d.count();
+            if(ticks < 0 || ticks > rep(std::numeric_limits<std::uint32_t>::max())) {
+                return std::chrono::duration_cast<ToDuration>(d);
+            }
+            return ToDuration{typename ToDuration::rep(
+              ToConversion<ToDuration>::convert(std::uint32_t(ticks)))};
+        }
 
-            while(true) {
-                currentCount  = apply(read(Regs::CVR::current));
-                localOverruns = overruns.load(std::memory_order_relaxed);
-                if(!fieldEquals(Regs::CSR::COUNTFLAGValC::timer_has_counted_to_0)) { break; }
+        template<typename FromDuration>
+        static constexpr duration fromDuration(FromDuration d) {
+            auto const count = d.count();
+            if(count < 0
+               || std::uint64_t(count) > std::uint64_t(std::numeric_limits<std::uint32_t>::max()))
+            {
+                return std::chrono::duration_cast<duration>(d);
             }
-            auto const cnd  = duration{reloadValue - currentCount};
-            auto const ovd  = duration{static_cast<std::uint64_t>(localOverruns)
-                                      * static_cast<std::uint64_t>(reloadValue + 1)};
-            auto const time = time_point{cnd + ovd};
-            return time;
+            return duration{rep(FromConversion<FromDuration>::convert(std::uint32_t(count)))};
+        }
+
+        // no retry loop, the counter, overruns and the pending wrap are read once with
+        // interrupts masked for a handful of instructions
+        static time_point now() {
+            Core::CriticalSection cs;
+            return time_point{duration{ticks<rep>()}};
+        }
+
+        static Timestamp32 now32() {
+            Core::CriticalSection cs;
+            return Timestamp32{ticks<std::uint32_t>()};
         }
 
         template<typename Duration,
@@ -206,6 +493,97 @@ namespace Systick {
             }
         }
 
+        // tickless only, makes sure a Systick interrupt fires no later than t
+        // the request is dropped once reached, so callers waiting on it re-request each wakeup
+        static void requestDeadline(time_point t) {
+            static_assert(Tickless, "deadlines need Config::tickless");
+            auto const ticks = std::uint64_t(std::max(t.time_since_epoch().count(), rep{0}));
+            Core::CriticalSection cs;
+            if(ticks < deadline) {
+                deadline = ticks;
+                reprogram();
+            }
+        }
+
+        // tickless only, sleeps in WFI until t is reached
+        static void sleepUntil(time_point t) {
+            static_assert(Tickless, "sleepUntil needs Config::tickless");
+            auto const ticks = std::uint64_t(std::max(t.time_since_epoch().count(), rep{0}));
+            while(true) {
+                Core::CriticalSection cs;
+                if(ticklessSnapshot().ticks >= ticks) { break; }
+                if(ticks < deadline) {
+                    deadline = ticks;
+                    reprogram();
+                }
+                // wakes on the pending Systick even though it is masked, the ISR runs once the
+                // critical section ends
+                SystemControl::waitForInterrupt();
+            }
+        }
+
+        // delay for a runtime duration, tickless only, the core sleeps in WFI for all but the
+        // last Config::wakeupTicks and spins only for that remainder (a fixed period clock could
+        // only sleep whole periods of up to 2^24 ticks, use delay<>() there)
+        // the delay ends within one now32() call (~20 cycles) after the requested tick as long as
+        // wakeupTicks covers the interrupt latency, lower priority ISRs delay the return further
+        // must not be called from the Systick ISR itself
+        static void delay(duration d) {
+            static_assert(Tickless, "a sleeping delay needs Config::tickless, use delay<>()");
+            if(d <= duration::zero()) { return; }
+            auto const     end    = now() + d;
+            constexpr auto wakeup = duration{Detail::wakeupTicks<Config>()};
+            if(d > wakeup + duration{minReload}) { sleepUntil(end - wakeup); }
+            while(now() < end) {}
+        }
+
+        template<typename Rep,
+                 typename Period>
+        static void delay(std::chrono::duration<Rep,
+                                                Period> d) {
+            delay(fromDuration(d));
+        }
+
+        struct Calibration {
+            bool          available;     // CALIB.TENMS is implemented (not 0)
+            bool          exact;         // !CALIB.SKEW
+            bool          noReference;   // CALIB.NOREF, only the processor clock exists
+            std::uint32_t tenMs;         // reload for 10ms according to the silicon
+            std::int32_t  errorPpm;      // clockSpeed against tenMs, 0 if not available
+        };
+
+        // compares Config::clockSpeed with the 10ms reload value of CALIB, call once after init
+        // TENMS is given for the Systick clock the vendor calibrated, usually the one selected by
+        // Config::clockBase, many parts leave it 0
+        static Calibration calibration() {
+            auto const calib = apply(read(Regs::CALIB::noref),
+                                     read(Regs::CALIB::skew),
+                                     read(Regs::CALIB::tenms));
+
+            Calibration result{};
+            result.noReference = static_cast<std::uint32_t>(get<0>(calib)) != 0;
+            result.exact       = static_cast<std::uint32_t>(get<1>(calib)) == 0;
+            result.tenMs       = static_cast<std::uint32_t>(get<2>(calib));
+            result.available   = result.tenMs != 0;
+            if(result.available) {
+                auto const calibrated = std::int64_t(result.tenMs) + 1;
+                auto const configured = std::int64_t(ClockSpeed / 100U);
+                result.errorPpm
+                  = std::int32_t(((configured - calibrated) * 1'000'000) / calibrated);
+            }
+            return result;
+        }
+
+        // true if CALIB is not implemented or agrees with Config::clockSpeed within tolerancePpm
+        static bool calibrationMatches(std::uint32_t tolerancePpm = 1000) {
+            Calibration const c = calibration();
+            if(!c.available) { return true; }
+            auto const error = c.errorPpm < 0 ? -std::int64_t(c.errorPpm) : std::int64_t(c.errorPpm);
+            // an inexact TENMS is off by up to one tick
+            auto const slack = c.exact ? 0 : 1'000'000 / (std::int64_t(c.tenMs) + 1);
+            return error <= std::int64_t(tolerancePpm) + slack;
+        }
+
         // kvasir init
         static constexpr auto initStepPeripheryConfig
           = list(write(Config::clockBase),
@@ -222,9 +600,10 @@ namespace Systick {
           = list(write(Regs::CSR::ENABLEValC::counter_is_operating),
                  makeEnable(Interrupt::systick));
 
-        static constexpr Nvic::Isr<std::addressof(onIsr),
-                                   std::decay_t<decltype(Interrupt::systick)>>
-          isr{};
+        static constexpr Nvic::Isr<isrHandler, std::decay_t<decltype(Interrupt::systick)>> isr{};
+
+        // the function behind isr, for delivering the interrupt in a host simulation
+        static constexpr void (*isrFunction)() = isrHandler;
     };
 }   // namespace Systick
 }   // namespace Kvasir
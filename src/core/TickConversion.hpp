@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <ratio>
+
+namespace Kvasir::Systick::Detail {
+
+// floor(x * Ratio) for 0 <= x <= MaxInput without a division, as (x * multiplier) >> shift
+// multiplier is the largest fixed point approximation of Ratio that still fits 32 bits, so the
+// product fits 64 bits which ARMv6-M does with a few MULS instead of a __aeabi_uldivmod call
+//
+// multiplier overestimates Ratio by at most (den - remainder) / (den * 2^shift), so the result
+// is floor(x * Ratio) + e with 0 <= e <= maxError and exact means maxError == 0
+template<typename Ratio,
+         std::uint64_t MaxInput = std::numeric_limits<std::uint32_t>::max()>
+struct ReciprocalConversion {
+private:
+    static constexpr std::uint64_t num = std::uint64_t(Ratio::num);
+    static constexpr std::uint64_t den = std::uint64_t(Ratio::den);
+
+    static_assert(Ratio::num > 0 && Ratio::den > 0, "only positive ratios are supported");
+    static_assert(MaxInput <= std::numeric_limits<std::uint32_t>::max(),
+                  "input has to fit 32 bits");
+    static_assert(den < (1ULL << 31U), "denominator to large for a 64 bit error bound");
+    static_assert(num / den <= std::numeric_limits<std::uint32_t>::max(), "ratio to large");
+
+    struct Params {
+        std::uint64_t multiplier;
+        unsigned      shift;
+        std::uint64_t remainder;
+    };
+
+    // long division of num * 2^shift by den one bit at a time, keeping the last shift whose
+    // rounded up quotient still fits 32 bits
+    static constexpr Params calcParams() {
+        std::uint64_t q = num / den;
+        std::uint64_t r = num % den;
+        Params        best{r == 0 ? q : q + 1, 0, r};
+        for(unsigned shift = 1; shift < 64; ++shift) {
+            q *= 2;
+            r *= 2;
+            if(r >= den) {
+                ++q;
+                r -= den;
+            }
+            std::uint64_t const m = r == 0 ? q : q + 1;
+            if(m > std::numeric_limits<std::uint32_t>::max()) { break; }
+            best = {m, shift, r};
+        }
+        return best;
+    }
+
+    static constexpr Params params = calcParams();
+
+    static constexpr bool calcExact() {
+        return params.remainder == 0
+            || MaxInput * (den - params.remainder) < (std::uint64_t(1) << params.shift);
+    }
+
+    static constexpr std::uint64_t calcMaxError() {
+        if(calcExact()) { return 0; }
+        std::uint64_t const scaled = MaxInput * (den - params.remainder);
+        std::uint64_t const shifted
+          = (scaled >> params.shift)
+          + ((scaled & ((std::uint64_t(1) << params.shift) - 1U)) != 0 ? 1U : 0U);
+        return (shifted + den - 1U) / den;
+    }
+
+public:
+    static constexpr std::uint64_t multiplier = params.multiplier;
+    static constexpr unsigned      shift      = params.shift;
+    static constexpr std::uint64_t maxInput   = MaxInput;
+    static constexpr bool          exact      = calcExact();
+    static constexpr std::uint64_t maxError   = calcMaxError();
+
+    static_assert(multiplier != 0, "ratio to small to be represented");
+
+    static constexpr std::uint64_t convert(std::uint32_t x) {
+        return (std::uint64_t(x) * multiplier) >> shift;
+    }
+};
+
+}   // namespace Kvasir::Systick::Detail
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "CriticalSection.hpp"
+#include "core_peripherals/SCB.hpp"
+#include "kvasir/Register/Register.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace Kvasir::Trace {
+
+// record codes, every record is <code> <varint delta ticks> [varint payload...], varints are
+// LEB128 (7 bits per byte, low first), the delta is to the previous record in the buffer
+// tools/decode_trace.py has to be kept in sync with the codes and the Header layout
+namespace Code {
+    static constexpr std::uint8_t enter  = 0x00;   // + exception number (11 SVCall, 14 PendSV)
+    static constexpr std::uint8_t exit   = 0x40;   // + exception number
+    static constexpr std::uint8_t marker = 0x80;   // payload id
+    static constexpr std::uint8_t value  = 0x81;   // payload id, value
+    static constexpr std::uint8_t sync   = 0xF0;   // delta field is the absolute now32() tick
+    static constexpr std::uint8_t lost   = 0xF1;   // payload number of dropped records
+}   // namespace Code
+
+// fixed layout in front of the buffer so decode_trace.py finds the trace in a RAM dump
+struct Header {
+    static constexpr std::uint32_t validMagic = 0x4B54'5232;   // "KTR2"
+
+    std::uint32_t magic;
+    std::uint32_t size;   // buffer bytes, a power of two
+    std::uint32_t ticksPerSecond;
+    std::uint32_t head;      // free running write index, records below it may be half written
+    std::uint32_t commit;    // free running index up to which all records are complete
+    std::uint32_t tail;      // free running read index
+    std::uint32_t dropped;   // records not written since the last lost record
+};
+
+static_assert(std::is_trivially_copyable_v<Header> && sizeof(Header) == 28,
+              "Header layout is shared with the host decoder");
+
+namespace Detail {
+    // longest record, code + three 5 byte varints
+    static constexpr std::uint32_t maxRecord = 16;
+
+    [[gnu::always_inline]] static inline std::uint8_t* putVarint(std::uint8_t* p,
+                                                                 std::uint32_t v) {
+        while(v >= 0x80U) {
+            *p++ = std::uint8_t(v | 0x80U);
+            v >>= 7U;
+        }
+        *p++ = std::uint8_t(v);
+        return p;
+    }
+
+    static constexpr std::uint32_t varintLength(std::uint32_t v) {
+        return 1U + std::uint32_t(v >= 1U << 7U) + std::uint32_t(v >= 1U << 14U)
+             + std::uint32_t(v >= 1U << 21U) + std::uint32_t(v >= 1U << 28U);
+    }
+
+    // the buffer has maxRecord spare bytes behind the ring so a record is written contiguously
+    // and only the part behind the end is copied to the front
+    template<std::size_t Bytes>
+    struct Storage {
+        Header                                       header;
+        std::array<std::uint8_t, Bytes + maxRecord> buffer;
+    };
+}   // namespace Detail
+
+// binary event trace in a RAM ring, timestamps are Clock::now32() ticks:
+//
+//   using Trace = Kvasir::Trace::Buffer<Clock, 1024>;
+//   Trace::start();
+//   static constexpr Nvic::Isr<Kvasir::Trace::Traced<Trace, std::addressof(onUart)>::function,
+//                              std::decay_t<decltype(Interrupt::usart0)>> isr{};
+//   Trace::marker(3);
+//
+// interrupts are only masked to take the timestamp and reserve the record (the delta chain has to
+// stay in buffer order), encoding runs unmasked and a record preempted there is completed before
+// the preempting one returns, commit is advanced once no record is half written and drain() only
+// reads up to it, an ISR enter/exit with a delta below 2^14 ticks is 3 bytes, counted from the
+// code the masked part is now32() plus about 20 cycles and the commit another 8, M0+ has no
+// cycle counter that would give a cheaper timestamp
+// a full buffer drops new records and counts them in a lost record, drain() frees space, gaps
+// between records of 2^32 ticks or more lose whole multiples of 2^32 in the decoded timeline
+template<typename Clock,
+         std::size_t Bytes>
+struct Buffer {
+    static constexpr std::size_t size = Bytes;
+
+private:
+    static_assert(Bytes >= 64 && (Bytes & (Bytes - 1)) == 0,
+                  "trace buffer size has to be a power of two of at least 64 bytes");
+
+    using ScbRegs = Kvasir::Peripheral::SCB::Registers<>;
+
+    static constexpr std::uint32_t mask = std::uint32_t(Bytes - 1);
+
+    static inline Detail::Storage<Bytes> storage{};
+    static inline std::uint32_t          last{};
+    static inline std::uint32_t          writers{};   // records reserved but not yet written
+
+    // writes one record at the reserved free running index at and returns the index behind it
+    [[gnu::always_inline]] static std::uint32_t put(std::uint32_t at,
+                                                    std::uint8_t  code,
+                                                    std::uint32_t delta,
+                                                    auto... payload) {
+        std::uint8_t* const begin = storage.buffer.data() + (at & mask);
+        std::uint8_t*       p     = begin;
+        *p++                      = code;
+        p                         = Detail::putVarint(p, delta);
+        ((p = Detail::putVarint(p, std::uint32_t(payload))), ...);
+        auto const          length = std::uint32_t(p - begin);
+        std::uint32_t const end    = (at & mask) + length;
+        for(std::uint32_t i = Bytes; i < end; ++i) {
+            storage.buffer[i - Bytes] = storage.buffer[i];
+        }
+        return at + length;
+    }
+
+    static void record(std::uint8_t code,
+                       auto... payload) {
+        std::uint32_t const length
+          = (1U + ... + Detail::varintLength(std::uint32_t(payload)));
+        std::uint32_t at;
+        std::uint32_t delta;
+        std::uint32_t lost = 0;
+        {
+            Core::CriticalSection cs;
+            std::uint32_t const   now = Clock::now32().ticks;
+            at                        = storage.header.head;
+            if(Bytes - (at - storage.header.tail) < 2 * Detail::maxRecord) {
+                ++storage.header.dropped;
+                return;
+            }
+            delta = now - last;
+            last  = now;
+            if(storage.header.dropped != 0) [[unlikely]] {
+                lost                   = storage.header.dropped;
+                storage.header.dropped = 0;
+                // the lost record takes the delta, the record itself follows with 0
+                storage.header.head
+                  = at + 2U + Detail::varintLength(delta) + Detail::varintLength(lost) + length;
+            } else {
+                storage.header.head = at + length + Detail::varintLength(delta);
+            }
+            ++writers;
+        }
+        if(lost != 0) [[unlikely]] {
+            at    = put(at, Code::lost, delta, lost);
+            delta = 0;
+        }
+        put(at, code, delta, payload...);
+        Core::CriticalSection cs;
+        if(--writers == 0) { storage.header.commit = storage.header.head; }
+    }
+
+public:
+    // clears the buffer and writes the sync record the deltas start from
+    static void start() {
+        Core::CriticalSection cs;
+        storage.header = Header{Header::validMagic,
+                                std::uint32_t(Bytes),
+                                std::uint32_t(Clock::duration::period::den
+                                              / Clock::duration::period::num),
+                                0,
+                                0,
+                                0,
+                                0};
+        std::uint32_t const now = Clock::now32().ticks;
+        last                    = now;
+        writers                 = 0;
+        storage.header.head     = put(0, Code::sync, now);
+        storage.header.commit   = storage.header.head;
+    }
+
+    // exception number from ICSR.VECTACTIVE, call first and last in the handler or use Traced
+    static void isrEnter() {
+        record(std::uint8_t(Code::enter | (apply(read(ScbRegs::ICSR::vectactive)) & 0x3FU)));
+    }
+
+    static void isrExit() {
+        record(std::uint8_t(Code::exit | (apply(read(ScbRegs::ICSR::vectactive)) & 0x3FU)));
+    }
+
+    static void marker(std::uint32_t id) { record(Code::marker, id); }
+
+    static void marker(std::uint32_t id,
+                       std::uint32_t value) {
+        record(Code::value, id, value);
+    }
+
+    // thread mode only, hands the complete unread bytes to sink(std::uint8_t const*, std::size_t) in at
+    // most two chunks (the ring wraps) and frees them, the concatenated chunks since start() are
+    // what decode_trace.py --stream reads
+    template<typename F>
+    static void drain(F&& sink) {
+        std::uint32_t const commit = storage.header.commit;
+        std::uint32_t       tail   = storage.header.tail;
+        while(tail != commit) {
+            std::uint32_t const at    = tail & mask;
+            std::uint32_t const chunk = std::min(commit - tail, std::uint32_t(Bytes) - at);
+            sink(static_cast<std::uint8_t const*>(storage.buffer.data() + at), std::size_t(chunk));
+            tail += chunk;
+        }
+        storage.header.tail = tail;
+    }
+
+    static std::uint32_t used() { return storage.header.commit - storage.header.tail; }
+};
+
+// wraps an ISR F with enter and exit records, also usable for the SVCall and PendSV handlers
+template<typename Trace,
+         void (*F)()>
+struct Traced {
+private:
+    static void handler() {
+        Trace::isrEnter();
+        F();
+        Trace::isrExit();
+    }
+
+public:
+    static constexpr void (*function)() = &handler;
+};
+
+}   // namespace Kvasir::Trace
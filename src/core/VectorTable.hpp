@@ -0,0 +1,86 @@
+#pragma once
+
+#include "core_peripherals/SCB.hpp"
+#include "kvasir/Common/Interrupt.hpp"
+#include "kvasir/Register/Register.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// places a function (an ISR or one of its callees) in RAM, the section is part of .data so the
+// .data copy at startup loads it, the linker adds veneers for calls between flash and RAM that
+// are further apart than the BL range
+// every callee on the hot path needs the attribute too, otherwise it still runs from flash
+#define KVASIR_RAM_FUNCTION [[gnu::section(".data.ramfunc"), gnu::noinline]]
+
+namespace Kvasir::Core {
+
+// copy of the vector table in RAM, selected through VTOR
+// with flash wait states both the vector fetch on exception entry and the handler code are
+// slower from flash, relocating the table and marking hot handlers KVASIR_RAM_FUNCTION removes
+// those wait states from the interrupt latency
+//
+// Entries defaults to the 16 core vectors plus all external interrupts of the chip
+template<std::size_t Entries = 16 + std::size_t(InterruptOffsetTraits<void>::end)>
+struct VectorTable {
+    using Handler = void (*)();
+
+private:
+    using ScbRegs = Kvasir::Peripheral::SCB::Registers<>;
+
+    // VTOR needs the table aligned to the next power of two of its size, at least 128 bytes
+    static constexpr std::size_t calcAlignment() {
+        std::size_t alignment = 128;
+        while(alignment < Entries * sizeof(Handler)) { alignment *= 2; }
+        return alignment;
+    }
+
+    static_assert(Entries >= 16 && Entries <= 48, "cortex_m0plus has 16 + up to 32 vectors");
+
+    alignas(calcAlignment()) static inline std::array<Handler, Entries> table{};
+
+    static volatile Handler* active() {
+        return reinterpret_cast<volatile Handler*>(
+          std::uintptr_t(apply(read(ScbRegs::VTOR::tbloff))) << 7U);
+    }
+
+public:
+    static constexpr std::size_t alignment = calcAlignment();
+
+    // copies the currently active (usually the flash) table and switches VTOR to the copy
+    // call before enabling interrupts, the handlers do not change in the process so it is also
+    // safe with interrupts running
+    static void relocate() {
+        volatile Handler* const source = active();
+        for(std::size_t i = 0; i < Entries; ++i) { table[i] = source[i]; }
+        asm volatile("dsb" ::: "memory");
+        apply(write(ScbRegs::VTOR::tbloff, std::uint32_t(std::uintptr_t(table.data()) >> 7U)));
+        asm volatile("dsb\n\t"
+                     "isb" ::
+                       : "memory");
+    }
+
+    // replaces the handler of interrupt I (Interrupt::x), needs relocate() first
+    // the single aligned word store is atomic, an exception entered concurrently fetches either
+    // the old or the new handler, the old one may still run once after this returns
+    template<typename I>
+    static Handler setHandler(I,
+                              Handler handler) {
+        constexpr int index = I{}.index();
+        static_assert(index >= -15 && std::size_t(index + 16) < Entries,
+                      "interrupt is not part of the vector table");
+        Handler const previous = table[std::size_t(index + 16)];
+        static_cast<volatile Handler&>(table[std::size_t(index + 16)]) = handler;
+        asm volatile("dsb" ::: "memory");
+        return previous;
+    }
+
+    static Handler handler(int index) { return table[std::size_t(index + 16)]; }
+
+    static bool isActive() {
+        return reinterpret_cast<volatile Handler*>(table.data()) == active();
+    }
+};
+
+}   // namespace Kvasir::Core
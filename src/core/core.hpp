@@ -10,7 +10,21 @@
 #include "core_peripherals/SYSTICK.hpp"
 
 //
+#include "ClockTrim.hpp"
+#include "CriticalSection.hpp"
+#include "DeferredWork.hpp"
+#include "Executor.hpp"
+#include "IsrStats.hpp"
+#include "Kernel.hpp"
+#include "Mpu.hpp"
 #include "Nvic.hpp"
+#include "Pool.hpp"
+#include "Profiler.hpp"
+#include "Resource.hpp"
+#include "Sections.hpp"
+#include "SoftTimer.hpp"
 #include "StartUp.hpp"
 #include "SystemControl.hpp"
 #include "Systick.hpp"
+#include "Trace.hpp"
+#include "VectorTable.hpp"
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdio>
+
+// minimal check for the host tests, failures are counted and printed, main returns the count
+namespace Kvasir::Test {
+inline int failures{};
+}   // namespace Kvasir::Test
+
+#define KVASIR_CHECK(condition)                                                           \
+    do {                                                                                  \
+        if(!(condition)) {                                                                \
+            if(Kvasir::Test::failures++ < 20) {                                           \
+                std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            }                                                                             \
+        }                                                                                 \
+    } while(false)
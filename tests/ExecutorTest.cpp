@@ -0,0 +1,109 @@
+#include "Check.hpp"
+#include "HostClock.hpp"
+#include "HostTiming.hpp"
+#include "core/Executor.hpp"
+
+#include <chrono>
+#include <csetjmp>
+#include <cstdint>
+#include <cstdio>
+
+// Executor on a tickless clock over the host model, run() never returns so every test has its
+// own executor (by the clock Tag) and leaves it with longjmp from the last coroutine
+
+namespace {
+namespace Exec = Kvasir::Executor;
+
+template<typename Tag>
+struct Setup : Kvasir::Test::HostClock<Tag, true> {
+    using Executor = Exec::Executor<typename Setup::Clock>;
+};
+
+std::jmp_buf done;
+
+// a coroutine yielding in a loop must not starve events and deadlines
+namespace Fairness {
+    using S = Setup<struct FairnessTag>;
+
+    Exec::Event   event;
+    std::uint32_t spins{};
+    bool          woken{};
+    bool          slept{};
+
+    Exec::Task spinner(Exec::TaskStorageBase&) {
+        while(true) {
+            // without fairness the others never run again, fail instead of hanging
+            if(++spins == 10'000'000) {
+                KVASIR_CHECK(woken && slept);
+                std::longjmp(done, 1);
+            }
+            co_await S::Executor::yield();
+        }
+    }
+
+    Exec::Task waiter(Exec::TaskStorageBase&) {
+        co_await S::Executor::wait(event);
+        woken = true;
+    }
+
+    Exec::Task signaller(Exec::TaskStorageBase&) {
+        co_await S::Executor::yield();
+        event.signal();
+    }
+
+    Exec::Task sleeper(Exec::TaskStorageBase&) {
+        co_await S::Executor::sleepFor(std::chrono::microseconds{100});
+        slept = true;
+        // the spinner is still going, it has been resumed once per pass
+        KVASIR_CHECK(woken && spins > 1);
+        std::longjmp(done, 1);
+    }
+
+    Exec::TaskStorage<256> storage[4];
+
+    void test() {
+        S::reset();
+        KVASIR_CHECK(S::Executor::spawn(spinner(storage[0])));
+        KVASIR_CHECK(S::Executor::spawn(waiter(storage[1])));
+        KVASIR_CHECK(S::Executor::spawn(signaller(storage[2])));
+        KVASIR_CHECK(S::Executor::spawn(sleeper(storage[3])));
+        if(setjmp(done) == 0) { S::Executor::run(); }
+        KVASIR_CHECK(woken && slept);
+    }
+}   // namespace Fairness
+
+// resume/suspend pairs through yield(), see HostTiming.hpp
+namespace Benchmark {
+    using S = Setup<struct BenchmarkTag>;
+
+    constexpr int tasks  = 4;
+    constexpr int rounds = 2'000'000;
+    int           finished{};
+
+    Exec::Task yielder(Exec::TaskStorageBase&) {
+        for(int i = 0; i < rounds; ++i) { co_await S::Executor::yield(); }
+        if(++finished == tasks) { std::longjmp(done, 1); }
+    }
+
+    Exec::TaskStorage<128> storage[tasks];
+
+    void test() {
+        S::reset();
+        for(auto& s : storage) { KVASIR_CHECK(S::Executor::spawn(yielder(s))); }
+        Kvasir::Test::hostTiming("ExecutorTest",
+                                 "resume/suspend",
+                                 std::uint64_t(rounds) * tasks,
+                                 [] {
+                                     if(setjmp(done) == 0) { S::Executor::run(); }
+                                 });
+        KVASIR_CHECK(finished == tasks);
+    }
+}   // namespace Benchmark
+}   // namespace
+
+int main() {
+    Fairness::test();
+    Benchmark::test();
+    std::printf("ExecutorTest: %d failures\n", Kvasir::Test::failures);
+    return Kvasir::Test::failures;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Check.hpp"
+#include "core/HostSystick.hpp"
+#include "core/Systick.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+// SystickClockBase over the host model for the tests, every Tag gets its own model and clock,
+// the clock state is static and survives a model reset
+// the model counts Systick ticks, one per register access, whatever clockSpeed says
+namespace Kvasir::Test {
+
+template<typename Tag,
+         bool          Tickless,
+         std::uint32_t SamplePeriod = 1U << 24U,
+         std::uint64_t ClockSpeed   = 48'000'000>
+struct HostClockConfig {
+    static constexpr std::uint64_t            clockSpeed = ClockSpeed;
+    static constexpr auto                     clockBase  = Kvasir::Systick::useProcessorClock;
+    static constexpr std::chrono::nanoseconds minOverrunTime{std::chrono::hours{24 * 365}};
+    static constexpr bool                     tickless = Tickless;
+    // with one cycle per access the CVR clear comes 3 accesses after the CVR read of the snapshot
+    static constexpr std::uint32_t reprogramTicks = 3;
+    static constexpr std::uint32_t samplePeriod   = SamplePeriod;
+    using hardware                                = Kvasir::Systick::Host::SimulatedSystick<Tag>;
+
+    static inline std::uint64_t isrs{};
+    static inline void (*tick)(){};   // e.g. TimerService::process
+
+    static void onTick() {
+        ++isrs;
+        if(tick != nullptr) { tick(); }
+    }
+};
+
+template<typename Tag,
+         bool          Tickless,
+         std::uint32_t SamplePeriod = 1U << 24U,
+         std::uint64_t ClockSpeed   = 48'000'000>
+struct HostClock {
+    using Cfg   = HostClockConfig<Tag, Tickless, SamplePeriod, ClockSpeed>;
+    using Model = Kvasir::Systick::Host::SimulatedSystick<Tag>;
+    using Clock = Kvasir::Systick::SystickClockBase<Cfg>;
+
+    // the reload the init steps would write
+    static void reset() { Model::reset(Clock::isrFunction, SamplePeriod - 1U); }
+
+    static std::uint64_t ticks() { return std::uint64_t(Clock::now().time_since_epoch().count()); }
+
+    // the tick count is the number of cycles since the first reload, read at the CVR access
+    static void checkNow(std::uint64_t& last,
+                         std::uint64_t  slack) {
+        std::uint64_t const t = ticks();
+        KVASIR_CHECK(t >= last);
+        KVASIR_CHECK(t <= Model::cycles && Model::cycles <= t + slack);
+        last = t;
+    }
+};
+
+}   // namespace Kvasir::Test
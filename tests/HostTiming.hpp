@@ -0,0 +1,25 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// wall clock time of a hot path on the host, printed per operation
+// a regression guard only, the numbers say nothing about cycle counts on the M0+
+namespace Kvasir::Test {
+
+template<typename F>
+void hostTiming(char const*   name,
+                char const*   operation,
+                std::uint64_t operations,
+                F&&           f) {
+    auto const start = std::chrono::steady_clock::now();
+    f();
+    auto const took = std::chrono::steady_clock::now() - start;
+    std::printf("%s: %.2f ns per %s (host time, regression guard only)\n",
+                name,
+                std::chrono::duration<double, std::nano>(took).count() / double(operations),
+                operation);
+}
+
+}   // namespace Kvasir::Test
@@ -0,0 +1,116 @@
+#include "Check.hpp"
+#include "HostTiming.hpp"
+#include "core/Pool.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+// BlockPool with an "ISR" allocating and releasing whenever thread code unmasks interrupts,
+// every block handed out must be unique and owned by the pool, the count must match
+
+namespace {
+using Pool = Kvasir::Core::BlockPool<60, 16>;
+namespace Host = Kvasir::Core::HostDetail;
+
+std::mt19937       rng{7};
+std::set<void*>    live;
+std::vector<void*> isrHeld;
+long               isrRuns{};
+
+void take(void* block) {
+    if(block == nullptr) { return; }
+    KVASIR_CHECK(Pool::owns(block));
+    KVASIR_CHECK(live.insert(block).second);
+    // the whole block is usable, a freelist link overwritten here would show up as a double
+    std::memset(block, 0xA5, Pool::blockSize);
+}
+
+void drop(void* block) {
+    live.erase(block);
+    Pool::release(block);
+}
+
+void isr() {
+    if(Host::primask) { return; }
+    Host::primask = true;
+    ++isrRuns;
+    if(rng() % 2 == 0) {
+        void* const block = Pool::allocate();
+        take(block);
+        if(block != nullptr) { isrHeld.push_back(block); }
+    } else if(!isrHeld.empty()) {
+        drop(isrHeld.back());
+        isrHeld.pop_back();
+    }
+    Host::primask = false;
+}
+
+void stress() {
+    Host::onUnmask = [] {
+        if(rng() % 3 == 0) { isr(); }
+    };
+    std::vector<void*> held;
+    for(int i = 0; i < 1'000'000; ++i) {
+        if(rng() % 2 == 0) {
+            void* const block = Pool::allocate();
+            take(block);
+            if(block != nullptr) { held.push_back(block); }
+        } else if(!held.empty()) {
+            auto const k = rng() % held.size();
+            drop(held[k]);
+            held.erase(held.begin() + std::ptrdiff_t(k));
+        }
+        Kvasir::Core::CriticalSection cs;
+        KVASIR_CHECK(Pool::available() == Pool::blocks - live.size());
+    }
+    Host::onUnmask = nullptr;
+    KVASIR_CHECK(isrRuns != 0);
+    KVASIR_CHECK(Pool::maxUsed() == Pool::blocks);
+    KVASIR_CHECK(!Pool::owns(static_cast<std::byte*>(*live.begin()) + 1));
+}
+
+void typed() {
+    using Typed = Kvasir::Core::BlockPool<32, 2, struct TypedTag>;
+    struct S {
+        int&   destroyed;
+        double d;
+        ~S() { ++destroyed; }
+    };
+    int destroyed = 0;
+    {
+        std::unique_ptr<S, Typed::Deleter> a{Typed::create<S>(destroyed, 1.0)};
+        std::unique_ptr<S, Typed::Deleter> b{Typed::create<S>(destroyed, 2.0)};
+        KVASIR_CHECK(a && b && a->d == 1.0 && b->d == 2.0);
+        KVASIR_CHECK(Typed::create<S>(destroyed, 3.0) == nullptr);
+    }
+    KVASIR_CHECK(destroyed == 2 && Typed::available() == 2);
+}
+
+// allocate/release pairs, see HostTiming.hpp, on the target both are a PRIMASK section of
+// about 10 instructions
+void benchmark() {
+    using Bench          = Kvasir::Core::BlockPool<64, 32, struct BenchTag>;
+    constexpr int rounds = 10'000'000;
+    Kvasir::Test::hostTiming("PoolTest", "allocate/release pair", rounds * 4ULL, [] {
+        void* blocks[4];
+        for(int i = 0; i < rounds; ++i) {
+            for(auto& b : blocks) { b = Bench::allocate(); }
+            for(auto* b : blocks) { Bench::release(b); }
+        }
+    });
+    KVASIR_CHECK(Bench::available() == Bench::blocks);
+}
+}   // namespace
+
+int main() {
+    stress();
+    typed();
+    benchmark();
+    std::printf("PoolTest: %d failures\n", Kvasir::Test::failures);
+    return Kvasir::Test::failures;
+}
@@ -0,0 +1,127 @@
+#include "Check.hpp"
+#include "HostClock.hpp"
+#include "core/SoftTimer.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+// TimerService on a tickless clock over the host model, driven from the Systick ISR through
+// onTick(), no timer may fire before its time and none later than a wheel tick after it
+
+namespace {
+using S       = Kvasir::Test::HostClock<struct SoftTimerTag, true>;
+using Service = Kvasir::Systick::TimerService<S::Clock>;
+using Timer   = Kvasir::Systick::Timer;
+using ticks   = S::Clock::duration;
+
+// one wheel tick (256 ticks), the shortest Systick period (minReload, a deadline closer than
+// that fires late), the 64 tick steps of run() and the register accesses up to the callback
+constexpr std::uint64_t lateSlack = 256 + 256 + 64 + 32;
+
+void onFire(Timer& t);
+
+struct Slot {
+    Timer         timer{&onFire};
+    std::uint64_t due{};
+    std::uint64_t period{};
+    std::uint64_t fired{};
+};
+
+std::array<Slot, 40> slots{};
+std::uint64_t        early{};
+std::uint64_t        maxLate{};
+std::uint64_t        fired{};
+
+void onFire(Timer& t) {
+    for(auto& s : slots) {
+        if(&s.timer != &t) { continue; }
+        std::uint64_t const now = S::ticks();
+        if(now < s.due) {
+            ++early;
+        } else if(now - s.due > maxLate) {
+            maxLate = now - s.due;
+        }
+        ++s.fired;
+        ++fired;
+        s.due += s.period;
+    }
+}
+
+void start(Slot&         s,
+           std::uint64_t delay,
+           std::uint64_t period = 0) {
+    s.due = S::ticks() + delay;
+    // periods run in whole wheel ticks
+    s.period = (period + 255U) / 256U * 256U;
+    Service::start(s.timer, ticks{std::int64_t(delay)}, ticks{std::int64_t(period)});
+}
+
+void run(std::uint64_t cycles) {
+    for(std::uint64_t i = 0; i < cycles / 64U; ++i) { S::Model::advance(64); }
+}
+
+void reset() {
+    for(auto& s : slots) { Service::cancel(s.timer); }
+    early   = 0;
+    maxLate = 0;
+    fired   = 0;
+}
+
+// delays shorter than and not aligned to a wheel tick, started at every offset within one
+void shortDelays() {
+    reset();
+    for(std::uint64_t offset = 0; offset < 256; offset += 7) {
+        run(offset);
+        start(slots[0], 480);
+        run(2000);
+        KVASIR_CHECK(slots[0].fired == offset / 7 + 1);
+    }
+    KVASIR_CHECK(early == 0 && maxLate <= lateSlack);
+}
+
+// a delay of 0 or less fires on the next wheel tick instead of 2^31 wheel ticks later
+void pastDeadline() {
+    reset();
+    slots[1].fired = 0;
+    slots[1].due   = S::ticks();
+    Service::start(slots[1].timer, ticks{-1000});
+    run(1000);
+    KVASIR_CHECK(slots[1].fired == 1 && !Service::isActive(slots[1].timer));
+}
+
+// 40 timers restarted, cancelled and periodic at random
+void stress() {
+    reset();
+    std::mt19937 rng{5};
+    for(int i = 0; i < 20'000; ++i) {
+        Slot& s = slots[rng() % slots.size()];
+        switch(rng() % 4) {
+        case 0: Service::cancel(s.timer); break;
+        case 1: start(s, 1 + rng() % 200'000, 1000 + rng() % 100'000); break;
+        default: start(s, 1 + rng() % 200'000); break;
+        }
+        run(rng() % 4000);
+    }
+    run(400'000);
+    KVASIR_CHECK(fired > 10'000);
+    KVASIR_CHECK(early == 0);
+    KVASIR_CHECK(maxLate <= lateSlack);
+    std::printf("SoftTimerTest: %llu timers fired, %llu early, at most %llu ticks late\n",
+                static_cast<unsigned long long>(fired),
+                static_cast<unsigned long long>(early),
+                static_cast<unsigned long long>(maxLate));
+}
+}   // namespace
+
+int main() {
+    S::reset();
+    S::Cfg::tick = &Service::process;
+    shortDelays();
+    pastDeadline();
+    stress();
+    std::printf("SoftTimerTest: %d failures\n", Kvasir::Test::failures);
+    return Kvasir::Test::failures;
+}
@@ -0,0 +1,278 @@
+#include "Check.hpp"
+#include "HostClock.hpp"
+#include "HostTiming.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <type_traits>
+#include <utility>
+
+// SystickClockBase against the host model, periodic and tickless, with wraps forced into the
+// windows between the register reads
+
+namespace {
+template<typename Tag,
+         bool          Tickless,
+         std::uint32_t SamplePeriod = 1U << 24U,
+         std::uint64_t ClockSpeed   = 48'000'000>
+using Setup = Kvasir::Test::HostClock<Tag, Tickless, SamplePeriod, ClockSpeed>;
+
+template<typename Tag,
+         bool          Tickless,
+         std::uint32_t SamplePeriod = 1U << 24U>
+void randomReads(bool deadlines) {
+    using S = Setup<Tag, Tickless, SamplePeriod>;
+    S::reset();
+    std::mt19937  rng{1};
+    std::uint64_t last = 0;
+    for(int i = 0; i < 500'000; ++i) {
+        // a stall of more than a period is a lost period, as on the hardware
+        if(rng() % 50 == 0) { S::Model::advance(rng() % SamplePeriod); }
+        if constexpr(Tickless) {
+            if(deadlines && rng() % 3 == 0) {
+                S::Clock::requestDeadline(S::Clock::now()
+                                          + typename S::Clock::duration{300 + rng() % 2000});
+            }
+        }
+        // only between the reads of now(), a stall inside the restart window (an NMI) is lost
+        if(rng() % 7 == 0) {
+            S::Model::injectAt(rng() % 4, [] { S::Model::advance(1000); });
+        }
+        // an injected stall can land between the CVR read and the end of now()
+        S::checkNow(last, 1200);
+    }
+}
+
+// a wrap exactly at every access of now(), covers the count 0 with the interrupt pending
+template<typename Tag,
+         bool Tickless>
+void wrapAtEveryAccess() {
+    using S = Setup<Tag, Tickless>;
+    S::reset();
+    std::uint64_t last = 0;
+    // now() reads CVR, the pending bit and with a wrap pending CVR again
+    for(std::uint32_t at = 1; at <= 3; ++at) {
+        S::Model::advance(S::Model::cyclesToZero() + 1000);
+        S::Model::advance(S::Model::cyclesToZero() - at);
+        Kvasir::Core::CriticalSection cs;
+        S::checkNow(last, 8);
+    }
+}
+
+// the reload must not change under a running period, now() stays exact over many deadlines
+void deadlinesStayExact() {
+    using S = Setup<struct DeadlinesStayExact, true>;
+    S::reset();
+    std::mt19937  rng{2};
+    std::uint64_t last = 0;
+    for(int i = 0; i < 200'000; ++i) {
+        S::Clock::requestDeadline(S::Clock::now() + S::Clock::duration{300 + rng() % 2000});
+        S::Model::advance(rng() % 3000);
+        S::checkNow(last, 8);
+    }
+}
+
+// interrupts masked longer than the short period right after a deadline restart
+void maskedAfterRestart() {
+    using S = Setup<struct MaskedAfterRestart, true>;
+    S::reset();
+    S::Model::advance(10'000);
+    for(std::uint64_t masked : {500U, 2000U, 100'000U}) {
+        std::uint64_t const before = S::ticks();
+        S::Clock::requestDeadline(S::Clock::now() + S::Clock::duration{300});
+        {
+            Kvasir::Core::CriticalSection cs;
+            S::Model::advance(masked);
+        }
+        std::uint64_t const after = S::ticks();
+        KVASIR_CHECK(after - before >= masked && after - before <= masked + 16);
+    }
+}
+
+// samplePeriod is the Systick rate with far or no deadlines, tickless only adds interrupts
+template<typename Tag,
+         bool Tickless>
+void samplePeriod() {
+    using S = Setup<Tag, Tickless, 48'000>;
+    S::reset();
+    auto const second = [] {
+        for(int i = 0; i < 48'000; ++i) { S::Model::advance(1000); }
+    };
+    (void)S::ticks();
+    second();
+    std::uint64_t const isrs = S::Cfg::isrs;
+    KVASIR_CHECK(isrs >= 999 && isrs <= 1001);
+    if constexpr(Tickless) {
+        S::Clock::requestDeadline(S::Clock::now() + std::chrono::seconds{10});
+        second();
+        KVASIR_CHECK(S::Cfg::isrs - isrs >= 999 && S::Cfg::isrs - isrs <= 1001);
+    }
+    KVASIR_CHECK(S::ticks() <= S::Model::cycles && S::Model::cycles <= S::ticks() + 8);
+}
+
+// a deadline shortly after the end of the running period only shortens the next reload, the
+// reload has to return to samplePeriod after it or Systick keeps firing every minReload ticks
+template<typename Tag,
+         std::uint32_t SamplePeriod>
+void reloadRestored() {
+    using S        = Setup<Tag, true, SamplePeriod>;
+    using duration = typename S::Clock::duration;
+    S::reset();
+    auto const rate = [](int seconds) {
+        std::uint64_t const isrs = S::Cfg::isrs;
+        for(int i = 0; i < seconds * 480'000; ++i) { S::Model::advance(100); }
+        return (S::Cfg::isrs - isrs) / std::uint64_t(seconds);
+    };
+    std::uint64_t const expected = 48'000'000 / SamplePeriod;
+    (void)rate(1);
+    for(std::uint64_t after : {1U, 100U, 256U, 257U, 300U}) {
+        {
+            Kvasir::Core::CriticalSection cs;
+            S::Clock::requestDeadline(S::Clock::now()
+                                      + duration{std::int64_t(S::Model::cyclesToZero() + after)});
+        }
+        KVASIR_CHECK(rate(2) <= expected + 2);
+    }
+
+    // random deadlines 0.1 to 10 ms ahead, then none
+    std::mt19937  rng{3};
+    std::uint64_t last = S::ticks();
+    for(int i = 0; i < 20'000; ++i) {
+        S::Clock::requestDeadline(S::Clock::now() + duration{4800 + rng() % 475'200});
+        for(int j = 0; j < 48; ++j) { S::Model::advance(100); }
+        S::checkNow(last, 8);
+    }
+    KVASIR_CHECK(rate(2) <= expected + 2);
+}
+
+// the model registers SystickClockBase does not use, COUNTFLAG, TICKINT and PENDSTSET/CLR,
+// every access below advances the counter by one tick as well
+void modelRegisters() {
+    using S = Setup<struct ModelRegisters, false, 1000>;
+    S::reset();
+    S::Model::advance(1);
+    KVASIR_CHECK(!S::Model::readCountFlag());
+    S::Model::advance(S::Model::cyclesToZero() - 1);
+    KVASIR_CHECK(S::Model::current == 1 && S::Model::isrCount == 0);
+    S::Model::advance(1);
+    KVASIR_CHECK(S::Model::isrCount == 1);
+    KVASIR_CHECK(S::Model::readCountFlag());
+    KVASIR_CHECK(!S::Model::readCountFlag());
+    S::Model::advance(S::Model::cyclesToZero());
+    S::Model::clearCount();
+    KVASIR_CHECK(!S::Model::readCountFlag());
+
+    S::Model::setTickInt(false);
+    S::Model::advance(5000);
+    KVASIR_CHECK(S::Model::isrCount == 2 && !S::Model::pending);
+    KVASIR_CHECK(S::Model::readCountFlag());
+    S::Model::setTickInt(true);
+    {
+        Kvasir::Core::CriticalSection cs;
+        S::Model::setPending();
+        KVASIR_CHECK(S::Model::wrapPending());
+        S::Model::clearPending();
+    }
+    KVASIR_CHECK(S::Model::isrCount == 2);
+    S::Model::setPending();
+    KVASIR_CHECK(S::Model::isrCount == 3 && !S::Model::pending);
+}
+
+// runtime delay (tickless) and compile time delay<>() (fixed period, delay_ticks) against the
+// clock rates of a 32 kHz crystal, an RC oscillator and a PLL, the tickless delay has to take
+// the converted duration plus at most the spin after wakeupTicks, the table shows how far the
+// conversion to ticks is off the requested time at each rate
+template<std::uint64_t ClockSpeed,
+         int... Us>
+void delayAccuracy() {
+    struct TicklessTag;
+    struct PeriodicTag;
+    using T = Setup<TicklessTag, true, 1U << 24U, ClockSpeed>;
+    using P = Setup<PeriodicTag, false, 1U << 24U, ClockSpeed>;
+
+    auto const report = [](char const* mode, int us, std::uint64_t took) {
+        double const exact = double(us) * double(ClockSpeed) / 1e6;
+        std::printf("SystickTest: %-9s %8llu Hz %7d us: %12.2f ticks wanted, %9llu taken, "
+                    "%+.0f ns\n",
+                    mode,
+                    static_cast<unsigned long long>(ClockSpeed),
+                    us,
+                    exact,
+                    static_cast<unsigned long long>(took),
+                    (double(took) - exact) * 1e9 / double(ClockSpeed));
+    };
+
+    T::reset();
+    for(int us : {Us...}) {
+        auto const          wanted = T::Clock::fromDuration(std::chrono::microseconds{us}).count();
+        double const        exact  = double(us) * double(ClockSpeed) / 1e6;
+        std::uint64_t const start  = T::Model::cycles;
+        T::Clock::delay(std::chrono::microseconds{us});
+        std::uint64_t const took = T::Model::cycles - start;
+        KVASIR_CHECK(wanted >= exact - 1.0 && wanted <= exact + 1.0);
+        KVASIR_CHECK(took >= std::uint64_t(wanted) && took <= std::uint64_t(wanted) + 64U);
+        report("tickless", us, took);
+    }
+
+    P::reset();
+    (void)P::ticks();
+    auto const periodic = []<int U>(std::integral_constant<int, U>) {
+        constexpr auto wanted
+          = std::chrono::duration_cast<typename P::Clock::duration>(std::chrono::microseconds{U})
+              .count();
+        std::uint64_t const start = P::Model::cycles;
+        P::Clock::template delay<std::chrono::microseconds, U>();
+        return std::pair{std::uint64_t(wanted), P::Model::cycles - start};
+    };
+    (
+      [&] {
+          auto const [wanted, took] = periodic(std::integral_constant<int, Us>{});
+          KVASIR_CHECK(took >= wanted && took <= wanted + 16U);
+          report("periodic", Us, took);
+      }(),
+      ...);
+}
+
+// now() on the host, see HostTiming.hpp
+template<bool Tickless>
+void nowTiming() {
+    struct Tag;
+    using S              = Setup<Tag, Tickless>;
+    constexpr int rounds = 10'000'000;
+    S::reset();
+    std::uint64_t sum = 0;
+    Kvasir::Test::hostTiming("SystickTest",
+                             Tickless ? "tickless now()" : "periodic now()",
+                             rounds,
+                             [&] {
+                                 for(int i = 0; i < rounds; ++i) { sum += S::ticks(); }
+                             });
+    KVASIR_CHECK(sum != 0);
+}
+}   // namespace
+
+int main() {
+    randomReads<struct RandomPeriodic, false>(false);
+    randomReads<struct RandomTickless, true>(false);
+    randomReads<struct RandomDeadlines, true>(true);
+    wrapAtEveryAccess<struct WrapPeriodic, false>();
+    wrapAtEveryAccess<struct WrapTickless, true>();
+    randomReads<struct RandomSampledPeriodic, false, 48'000>(false);
+    randomReads<struct RandomSampledTickless, true, 48'000>(false);
+    samplePeriod<struct SamplePeriodic, false>();
+    samplePeriod<struct SampleTickless, true>();
+    reloadRestored<struct ReloadRestored, 1U << 24U>();
+    reloadRestored<struct ReloadRestoredSampled, 48'000>();
+    deadlinesStayExact();
+    maskedAfterRestart();
+    modelRegisters();
+    delayAccuracy<32'768, 10, 100, 1000, 100'000, 1'000'000>();
+    delayAccuracy<12'000'000, 10, 100, 1000, 100'000>();
+    delayAccuracy<48'000'000, 10, 100, 1000, 100'000>();
+    nowTiming<false>();
+    nowTiming<true>();
+    std::printf("SystickTest: %d failures\n", Kvasir::Test::failures);
+    return Kvasir::Test::failures;
+}
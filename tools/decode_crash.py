@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""Decode Kvasir::Core::Fault::CrashRecord entries.
+
+Input is either a raw memory dump of a CrashRing (e.g. `dump binary memory`
+from gdb over the ring) or hex text of one or more records as printed by a
+drain() sink. Records with a wrong magic or CRC are skipped unless --all is
+given. The layout has to match src/core/CrashRecord.hpp.
+"""
+
+import argparse
+import re
+import struct
+import sys
+import zlib
+
+RECORD = struct.Struct("<IIQ4BII8I3I")
+VALID_MAGIC = 0x4B435231
+
+FAULT_TYPES = ["Hard"]
+DESCRIPTIONS = [
+    "ExternalDebug",
+    "VectorCatch",
+    "DWTTrap",
+    "Breakpoint",
+    "HaltRequest",
+    "EscalatedFault",
+]
+FRAME = ["R0", "R1", "R2", "R3", "R12", "LR", "PC", "xPSR"]
+
+
+def name(table, index):
+    return table[index] if index < len(table) else f"unknown({index})"
+
+
+def exc_return(value):
+    mode = "thread" if value & 0x8 else "handler"
+    stack = "PSP" if value & 0x4 else "MSP"
+    return f"{value:#010x} (return to {mode} mode, {stack})"
+
+
+def decode(raw, offset, show_invalid):
+    fields = RECORD.unpack_from(raw, offset)
+    magic, sequence, timestamp, ftype, desc, has_addr, _, addr, status = fields[:9]
+    frame = fields[9:17]
+    exc, _, crc = fields[17:20]
+    valid = magic == VALID_MAGIC and zlib.crc32(raw[offset:offset + RECORD.size - 4]) == crc
+    if not valid and not show_invalid:
+        return None, None
+
+    lines = [
+        f"record #{sequence} at offset {offset}{'' if valid else ' (INVALID)'}",
+        f"  {name(FAULT_TYPES, ftype)}Fault {name(DESCRIPTIONS, desc)}"
+        f" status={status:#010x}"
+        + (f" address={addr:#010x}" if has_addr else ""),
+        f"  timestamp={timestamp} ticks",
+        "  " + " ".join(f"{r}={v:#010x}" for r, v in zip(FRAME, frame)),
+        f"  EXC_RETURN={exc_return(exc)}",
+    ]
+    return sequence, "\n".join(lines)
+
+
+def read_input(path, as_hex):
+    data = sys.stdin.buffer.read() if path == "-" else open(path, "rb").read()
+    if as_hex:
+        return bytes.fromhex(re.sub(rb"[^0-9a-fA-F]", b"", data).decode())
+    return data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="dump file, - for stdin")
+    parser.add_argument("--hex", action="store_true", help="input is hex text")
+    parser.add_argument("--all", action="store_true", help="also show invalid records")
+    args = parser.parse_args()
+
+    raw = read_input(args.input, args.hex)
+    records = []
+    for offset in range(0, len(raw) - RECORD.size + 1, RECORD.size):
+        sequence, text = decode(raw, offset, args.all)
+        if text is not None:
+            records.append((sequence, text))
+    # oldest first, like CrashRing::drain()
+    for _, text in sorted(records):
+        print(text)
+    if not records:
+        print("no valid crash records", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""Print the timeline of a Kvasir::Trace::Buffer.
+
+Input is either a raw RAM dump containing the trace (e.g. `dump binary
+memory` from gdb over the whole RAM), the trace is found by the header magic,
+or with --stream the bytes handed to drain() since start(). Times are shown
+in microseconds since the first record, a dump whose beginning was already
+drained starts at an arbitrary record. ISR exit lines show the time since the
+matching enter, nested ISRs included. The format has to match src/core/Trace.hpp.
+"""
+
+import argparse
+import struct
+import sys
+
+HEADER = struct.Struct("<7I")
+VALID_MAGIC = 0x4B545232
+
+ENTER, EXIT, MARKER, VALUE, SYNC, LOST = 0x00, 0x40, 0x80, 0x81, 0xF0, 0xF1
+PAYLOADS = {MARKER: 1, VALUE: 2, SYNC: 0, LOST: 1}
+
+EXCEPTIONS = {
+    0: "thread",
+    2: "NMI",
+    3: "HardFault",
+    11: "SVCall",
+    14: "PendSV",
+    15: "SysTick",
+}
+
+
+def exception_name(number):
+    if number in EXCEPTIONS:
+        return EXCEPTIONS[number]
+    return f"IRQ{number - 16}" if number >= 16 else f"exception{number}"
+
+
+def varint(data, pos):
+    value, shift = 0, 0
+    while True:
+        if pos >= len(data):
+            raise EOFError
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if byte < 0x80:
+            return value, pos
+
+
+def records(data):
+    pos = 0
+    while pos < len(data):
+        code = data[pos]
+        try:
+            delta, next_pos = varint(data, pos + 1)
+            payload = []
+            for _ in range(PAYLOADS.get(code, 0) if code >= MARKER else 0):
+                value, next_pos = varint(data, next_pos)
+                payload.append(value)
+        except EOFError:
+            sys.stderr.write(f"truncated record at byte {pos}\n")
+            return
+        if code >= MARKER and code not in PAYLOADS:
+            sys.stderr.write(f"unknown code {code:#04x} at byte {pos}, stopping\n")
+            return
+        yield code, delta, payload
+        pos = next_pos
+
+
+def timeline(data, hz):
+    time, enters = 0, {}
+    for code, delta, payload in records(data):
+        if code == SYNC:
+            time = delta
+            yield time, "sync"
+            continue
+        time += delta
+        if code == LOST:
+            text = f"LOST {payload[0]} records"
+        elif code == MARKER:
+            text = f"marker {payload[0]}"
+        elif code == VALUE:
+            text = f"marker {payload[0]} = {payload[1]} ({payload[1]:#x})"
+        elif code >= EXIT:
+            number = code - EXIT
+            stack = enters.get(number)
+            start = stack.pop() if stack else None
+            took = "" if start is None else f"  ({(time - start) * 1e6 / hz:.2f} us)"
+            text = f"exit  {exception_name(number)}{took}"
+        else:
+            enters.setdefault(code, []).append(time)
+            text = f"enter {exception_name(code)}"
+        yield time, text
+
+
+def from_dump(raw):
+    offset = raw.find(struct.pack("<I", VALID_MAGIC))
+    while offset != -1:
+        magic, size, hz, head, commit, tail, dropped = HEADER.unpack_from(raw, offset)
+        begin = offset + HEADER.size
+        if size and size & (size - 1) == 0 and commit - tail <= size and begin + size <= len(raw):
+            # records between commit and head were being written when the dump was taken
+            ring = raw[begin:begin + size]
+            data = bytes(ring[i % size] for i in range(tail, commit))
+            return data, hz, dropped
+        offset = raw.find(struct.pack("<I", VALID_MAGIC), offset + 1)
+    sys.exit("no trace header found")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="dump file, - for stdin")
+    parser.add_argument("--stream", action="store_true", help="input is drain() output")
+    parser.add_argument("--hz", type=int, help="tick rate, required with --stream")
+    args = parser.parse_args()
+
+    raw = sys.stdin.buffer.read() if args.input == "-" else open(args.input, "rb").read()
+    if args.stream:
+        if not args.hz:
+            sys.exit("--stream needs --hz")
+        data, hz, dropped = raw, args.hz, 0
+    else:
+        data, hz, dropped = from_dump(raw)
+        hz = args.hz or hz
+
+    first = None
+    for time, text in timeline(data, hz):
+        if first is None:
+            first = time
+        print(f"{(time - first) * 1e6 / hz:14.2f} us  {text}")
+    if dropped:
+        print(f"{dropped} records dropped after the last one")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+"""Map a Kvasir::Systick::PcProfile dump to functions.
+
+Reads the PCPROF lines of PcProfile::dump() (other log lines are ignored)
+and the function symbols of the firmware ELF via nm. A bucket that spans
+several functions is split between them by the bytes of overlap, so results
+get more exact with smaller buckets.
+"""
+
+import argparse
+import bisect
+import re
+import subprocess
+import sys
+from collections import defaultdict
+
+HEADER = re.compile(r"PCPROF begin=(0x[0-9a-fA-F]+) bucket=(\d+) outside=(\d+)")
+BUCKET = re.compile(r"PCPROF (0x[0-9a-fA-F]+) (\d+)\s*$")
+
+
+def parse(lines):
+    bucket_bytes, outside, buckets = None, 0, []
+    for line in lines:
+        if m := HEADER.search(line):
+            bucket_bytes, outside = int(m.group(2)), int(m.group(3))
+        elif m := BUCKET.search(line):
+            buckets.append((int(m.group(1), 16), int(m.group(2))))
+    if bucket_bytes is None:
+        sys.exit("no PCPROF header found")
+    return bucket_bytes, outside, buckets
+
+
+def functions(elf, nm):
+    output = subprocess.run(
+        [nm, "-S", "-C", "--defined-only", elf], check=True, capture_output=True, text=True
+    ).stdout
+    symbols = []
+    for line in output.splitlines():
+        parts = line.split(maxsplit=3)
+        if len(parts) == 4 and parts[2] in "tTwW":
+            start = int(parts[0], 16) & ~1
+            symbols.append((start, start + int(parts[1], 16), parts[3]))
+    symbols.sort()
+    return symbols
+
+
+def attribute(bucket_bytes, buckets, symbols):
+    starts = [s[0] for s in symbols]
+    totals = defaultdict(float)
+    for begin, count in buckets:
+        end = begin + bucket_bytes
+        covered = 0
+        i = max(bisect.bisect_right(starts, begin) - 1, 0)
+        while i < len(symbols) and symbols[i][0] < end:
+            lo, hi = max(begin, symbols[i][0]), min(end, symbols[i][1])
+            if hi > lo:
+                totals[symbols[i][2]] += count * (hi - lo) / bucket_bytes
+                covered += hi - lo
+            i += 1
+        if covered < bucket_bytes:
+            totals["<no symbol>"] += count * (bucket_bytes - covered) / bucket_bytes
+    return totals
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="firmware ELF")
+    parser.add_argument("dump", nargs="?", default="-", help="log with PCPROF lines, - for stdin")
+    parser.add_argument("--nm", default="arm-none-eabi-nm")
+    parser.add_argument("--top", type=int, default=30, help="number of functions shown")
+    args = parser.parse_args()
+
+    lines = sys.stdin if args.dump == "-" else open(args.dump)
+    bucket_bytes, outside, buckets = parse(lines)
+    totals = attribute(bucket_bytes, buckets, functions(args.elf, args.nm))
+
+    samples = sum(count for _, count in buckets) + outside
+    if samples == 0:
+        sys.exit("no samples")
+    print(f"{samples} samples, {bucket_bytes} byte buckets, {outside} outside the code range")
+    for name, count in sorted(totals.items(), key=lambda t: -t[1])[: args.top]:
+        print(f"{100.0 * count / samples:6.2f}% {count:10.1f}  {name}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+"""Symbolize a Kvasir::Core::Fault::Backtrace.
+
+Takes the addresses of a COREFAULT backtrace(...) log line (or any hex
+addresses) from the command line or stdin and resolves them with addr2line
+against the firmware ELF. Return addresses point behind the call, so all but
+the first (the faulting PC) are moved back by 2 bytes to land on the call
+instruction itself.
+"""
+
+import argparse
+import re
+import subprocess
+import sys
+
+HEX = re.compile(r"0x[0-9a-fA-F]+")
+
+
+def parse(text):
+    # the count in backtrace(N) is decimal and skipped, zeros mark unused entries
+    return [int(h, 16) for h in HEX.findall(text) if int(h, 16) != 0]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="firmware ELF with debug info")
+    parser.add_argument("addresses", nargs="*", help="addresses or log line, stdin if empty")
+    parser.add_argument("--addr2line", default="arm-none-eabi-addr2line")
+    args = parser.parse_args()
+
+    text = " ".join(args.addresses) if args.addresses else sys.stdin.read()
+    addresses = parse(text)
+    if not addresses:
+        print("no addresses found", file=sys.stderr)
+        return 1
+
+    lookup = [a if i == 0 else a - 2 for i, a in enumerate(addresses)]
+    result = subprocess.run(
+        [args.addr2line, "-e", args.elf, "-f", "-C", "-i", "-p"] + [f"{a:#x}" for a in lookup],
+        check=True,
+        capture_output=True,
+        text=True,
+    )
+
+    # -i prints inlined frames as extra " (inlined by) " lines belonging to the previous address
+    frames = []
+    for line in result.stdout.splitlines():
+        if line.lstrip().startswith("(inlined by)") and frames:
+            frames[-1].append(line.strip())
+        else:
+            frames.append([line.strip()])
+
+    for i, (address, lines) in enumerate(zip(addresses, frames)):
+        print(f"#{i} {address:#010x} {lines[0]}")
+        for inlined in lines[1:]:
+            print(f"             {inlined}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())